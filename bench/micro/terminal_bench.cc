@@ -0,0 +1,573 @@
+// Micro-benchmarks for the market data hot path: JSON parsing and SBE
+// decoding, order book maintenance, stream dispatch and subject fan-out.
+// Order entry request building is compared against a JSON DOM.
+//
+// The SBE benchmarks decode the synthetic JSON events transcoded to SBE, so
+// both paths see the same data; each checks once that the two decode to the
+// same values before timing.
+//
+// Synthetic payloads are always benchmarked. Recorded traffic can be added
+// with `--payloads=<file>`, one raw combined-stream message per line
+// (`{"stream":"btcusdt@aggTrade","data":{...}}`).
+//
+// For regression tracking use Google Benchmark's machine-readable output:
+//   terminal_bench --benchmark_format=json --benchmark_out=bench.json
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "boost/asio/awaitable.hpp"
+#include "boost/asio/co_spawn.hpp"
+#include "boost/asio/detached.hpp"
+#include "boost/asio/io_context.hpp"
+#include "nlohmann/json.hpp"
+#include "openssl/hmac.h"
+#include "rpp/subjects/publish_subject.hpp"
+
+import exchange;
+import sbe;
+import state;
+
+namespace asio = boost::asio;
+
+namespace {
+// ---------------------------------------------------------------------------
+// Synthetic payloads.
+// ---------------------------------------------------------------------------
+constexpr double kMid = 100000.0;
+constexpr double kTick = 0.01;
+
+std::string TradeData(const uint64_t id) {
+  return std::format(
+      R"({{"e":"aggTrade","E":{},"s":"BTCUSDT","a":{},"p":"{:.2f}",)"
+      R"("q":"0.00{}","f":{},"l":{},"T":{},"m":{},"M":true}})",
+      1672515782136 + id, id, kMid + (id % 100) * kTick, 100 + id % 900, id,
+      id + 2, 1672515782136 + id, id % 2 == 0 ? "true" : "false");
+}
+
+std::string TradeMessage(const uint64_t id) {
+  return std::format(R"({{"stream":"btcusdt@aggTrade","data":{}}})",
+                     TradeData(id));
+}
+
+// Levels as Binance sends them: [["price","quantity"], ...]. One in five
+// levels is a removal (zero quantity).
+std::string Levels(std::mt19937_64& rng, const int count, const int depth,
+                   const int side) {
+  std::uniform_int_distribution<int> level(1, depth);
+  std::uniform_int_distribution<int> quantity(1, 99999);
+  std::string out = "[";
+  for (int i = 0; i < count; ++i) {
+    const double price = kMid + side * level(rng) * kTick;
+    const int qty = rng() % 5 == 0 ? 0 : quantity(rng);
+    out += std::format(R"({}["{:.2f}","{}.{:05}"])", i == 0 ? "" : ",", price,
+                       qty / 100000, qty % 100000);
+  }
+  return out + "]";
+}
+
+std::string DepthData(std::mt19937_64& rng, const int64_t first_id,
+                      const int diff, const int depth) {
+  return std::format(
+      R"({{"e":"depthUpdate","E":1672515782136,"s":"BTCUSDT","U":{},"u":{},)"
+      R"("b":{},"a":{}}})",
+      first_id, first_id + diff, Levels(rng, diff / 2 + diff % 2, depth, -1),
+      Levels(rng, diff / 2, depth, +1));
+}
+
+// Binance sends BTCUSDT prices and quantities with eight decimals.
+constexpr int8_t kSbeExponent = -8;
+
+int64_t Mantissa(const nlohmann::json& decimal) {
+  return sbe::mantissa(decimal.get_ref<const std::string&>(), kSbeExponent)
+      .value_or(0);
+}
+
+// TradeData(id) as a TradesStreamEvent.
+std::string TradeFrame(const uint64_t id) {
+  const auto j = nlohmann::json::parse(TradeData(id));
+  const sbe::TradeFields trade{.id = j.at("a").get<int64_t>(),
+                               .price = Mantissa(j.at("p")),
+                               .qty = Mantissa(j.at("q")),
+                               .is_buyer_maker = j.at("m").get<bool>()};
+  return sbe::encode_trades(j.at("E").get<int64_t>() * 1000,
+                            j.at("T").get<int64_t>() * 1000, kSbeExponent,
+                            kSbeExponent, {&trade, 1}, "BTCUSDT");
+}
+
+// A DepthData payload as a DepthDiffStreamEvent.
+std::string DepthFrame(const std::string& data) {
+  const auto j = nlohmann::json::parse(data);
+  const auto levels = [](const nlohmann::json& side) {
+    std::vector<sbe::LevelFields> out;
+    for (const auto& level : side) {
+      out.push_back({Mantissa(level.at(0)), Mantissa(level.at(1))});
+    }
+    return out;
+  };
+  return sbe::encode_depth_diff(
+      j.at("E").get<int64_t>() * 1000, j.at("U").get<int64_t>(),
+      j.at("u").get<int64_t>(), kSbeExponent, kSbeExponent, levels(j.at("b")),
+      levels(j.at("a")), "BTCUSDT");
+}
+
+// Fields both encodings carry (SBE has no aggregate trade ids).
+bool SameTrade(const state::Trade& a, const state::Trade& b) {
+  return a.event_time == b.event_time && a.symbol == b.symbol &&
+         a.trade_id == b.trade_id && a.price == b.price &&
+         a.quantity == b.quantity && a.trade_time == b.trade_time &&
+         a.is_buyer_market_maker == b.is_buyer_market_maker;
+}
+
+bool SameLevels(const std::vector<state::OrderBookEntry>& a,
+                const std::vector<state::OrderBookEntry>& b) {
+  return std::ranges::equal(a, b, [](const auto& x, const auto& y) {
+    return x.price == y.price && x.quantity == y.quantity;
+  });
+}
+
+bool SameUpdate(const state::OrderBookUpdate& a,
+                const state::OrderBookUpdate& b) {
+  return a.symbol == b.symbol && a.timestamp == b.timestamp &&
+         a.first_update_id == b.first_update_id &&
+         a.last_update_id == b.last_update_id && SameLevels(a.bids, b.bids) &&
+         SameLevels(a.asks, b.asks);
+}
+
+exchange::OrderBookSnapshot Snapshot(const int depth) {
+  exchange::OrderBookSnapshot snapshot{.last_update_id = 1};
+  for (int i = 1; i <= depth; ++i) {
+    snapshot.bids.push_back({std::format("{:.2f}", kMid - i * kTick), "1.5"});
+    snapshot.asks.push_back({std::format("{:.2f}", kMid + i * kTick), "1.5"});
+  }
+  return snapshot;
+}
+
+// Updates cycled through by the book benchmarks, so that the branch predictor
+// and caches do not see the same diff every iteration.
+std::vector<state::OrderBookUpdate> Updates(const int diff, const int depth) {
+  std::mt19937_64 rng(42);
+  std::vector<state::OrderBookUpdate> updates;
+  for (int i = 0; i < 64; ++i) {
+    updates.push_back(
+        nlohmann::json::parse(DepthData(rng, 2 + i * diff, diff, depth))
+            .get<state::OrderBookUpdate>());
+  }
+  return updates;
+}
+
+// Run `body` to completion on a fresh io_context, the way the socket read
+// loop drives handlers.
+template <typename Body>
+void RunCoroutine(Body&& body) {
+  asio::io_context io_context;
+  asio::co_spawn(io_context, std::forward<Body>(body), asio::detached);
+  io_context.run();
+}
+
+// ---------------------------------------------------------------------------
+// Parsing.
+// ---------------------------------------------------------------------------
+void BM_ParseTrade(benchmark::State& state) {
+  const std::string payload = TradeData(12345);
+  for (auto _ : state) {
+    auto trade = nlohmann::json::parse(payload).get<state::Trade>();
+    benchmark::DoNotOptimize(trade);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_ParseTrade);
+
+// from_json alone, on an already parsed document.
+void BM_FromJsonTrade(benchmark::State& state) {
+  const auto document = nlohmann::json::parse(TradeData(12345));
+  for (auto _ : state) {
+    auto trade = document.get<state::Trade>();
+    benchmark::DoNotOptimize(trade);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FromJsonTrade);
+
+void BM_ParseDepthUpdate(benchmark::State& state) {
+  std::mt19937_64 rng(42);
+  const std::string payload =
+      DepthData(rng, 1, static_cast<int>(state.range(0)), 1000);
+  for (auto _ : state) {
+    auto update = nlohmann::json::parse(payload).get<state::OrderBookUpdate>();
+    benchmark::DoNotOptimize(update);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_ParseDepthUpdate)
+    ->ArgName("levels")
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000);
+
+void BM_FromJsonDepthUpdate(benchmark::State& state) {
+  std::mt19937_64 rng(42);
+  const auto document = nlohmann::json::parse(
+      DepthData(rng, 1, static_cast<int>(state.range(0)), 1000));
+  for (auto _ : state) {
+    auto update = document.get<state::OrderBookUpdate>();
+    benchmark::DoNotOptimize(update);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FromJsonDepthUpdate)
+    ->ArgName("levels")
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000);
+
+void BM_DecodeSbeTrade(benchmark::State& state) {
+  const std::string frame = TradeFrame(12345);
+  std::vector<state::Trade> trades;
+  const auto expected =
+      nlohmann::json::parse(TradeData(12345)).get<state::Trade>();
+  if (!state::from_sbe(frame, trades) || trades.size() != 1 ||
+      !SameTrade(trades.front(), expected)) {
+    state.SkipWithError("SBE trade does not match its JSON source");
+    return;
+  }
+  for (auto _ : state) {
+    state::from_sbe(frame, trades);
+    benchmark::DoNotOptimize(trades.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_DecodeSbeTrade);
+
+void BM_DecodeSbeDepthUpdate(benchmark::State& state) {
+  std::mt19937_64 rng(42);
+  const std::string payload =
+      DepthData(rng, 1, static_cast<int>(state.range(0)), 1000);
+  const std::string frame = DepthFrame(payload);
+  const auto expected =
+      nlohmann::json::parse(payload).get<state::OrderBookUpdate>();
+  state::OrderBookUpdate decoded{};
+  if (!state::from_sbe(frame, decoded) || !SameUpdate(decoded, expected)) {
+    state.SkipWithError("SBE depth update does not match its JSON source");
+    return;
+  }
+  for (auto _ : state) {
+    state::OrderBookUpdate update{};
+    state::from_sbe(frame, update);
+    benchmark::DoNotOptimize(update);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_DecodeSbeDepthUpdate)
+    ->ArgName("levels")
+    ->Arg(1)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000);
+
+// ---------------------------------------------------------------------------
+// Order book maintenance.
+// ---------------------------------------------------------------------------
+void BM_ApplyUpdate(benchmark::State& state) {
+  const int depth = static_cast<int>(state.range(0));
+  const int diff = static_cast<int>(state.range(1));
+  asio::io_context io_context;
+  exchange::WebSocketAPI api(io_context);
+  state::OrderBookHandler handler(api);
+  handler.apply_snapshot(Snapshot(depth));
+  const auto updates = Updates(diff, depth);
+
+  size_t next = 0;
+  for (auto _ : state) {
+    auto delta = handler.apply_update(updates[next]);
+    benchmark::DoNotOptimize(delta);
+    next = (next + 1) % updates.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["levels"] = benchmark::Counter(
+      static_cast<double>(state.iterations()) * diff,
+      benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ApplyUpdate)
+    ->ArgNames({"depth", "diff"})
+    ->ArgsProduct({{100, 1000, 5000}, {1, 10, 100}});
+
+void BM_ApplySnapshot(benchmark::State& state) {
+  asio::io_context io_context;
+  exchange::WebSocketAPI api(io_context);
+  state::OrderBookHandler handler(api);
+  const auto snapshot = Snapshot(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    handler.apply_snapshot(snapshot);
+    benchmark::DoNotOptimize(handler.order_book());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ApplySnapshot)->ArgName("depth")->Arg(100)->Arg(1000)->Arg(5000);
+
+// ---------------------------------------------------------------------------
+// Dispatch and publication.
+// ---------------------------------------------------------------------------
+
+// Full message path for a trade: parse, stream lookup among `range(0)`
+// registered streams, from_json and publication.
+void BM_ProcessMessage(benchmark::State& state) {
+  asio::io_context io_context;
+  exchange::WebSocketStreams ws(io_context);
+  ws.register_handler("btcusdt@aggTrade",
+                      std::make_unique<state::TradeHandler>());
+  for (int i = 1; i < state.range(0); ++i) {
+    ws.register_handler(std::format("sym{}usdt@aggTrade", i),
+                        std::make_unique<state::TradeHandler>());
+  }
+  const std::string message = TradeMessage(12345);
+
+  RunCoroutine([&] -> asio::awaitable<void> {
+    for (auto _ : state) {
+      co_await ws.process_message(message);
+    }
+  });
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+BENCHMARK(BM_ProcessMessage)->ArgName("streams")->Arg(1)->Arg(16)->Arg(256);
+
+// BM_ProcessMessage for the same trade received as an SBE frame.
+void BM_ProcessSbeMessage(benchmark::State& state) {
+  asio::io_context io_context;
+  exchange::WebSocketStreams ws(io_context);
+  ws.register_handler(
+      "btcusdt@trade",
+      std::make_unique<state::TradeHandler>(exchange::Encoding::kSbe));
+  for (int i = 1; i < state.range(0); ++i) {
+    ws.register_handler(
+        std::format("sym{}usdt@trade", i),
+        std::make_unique<state::TradeHandler>(exchange::Encoding::kSbe));
+  }
+  const std::string frame = TradeFrame(12345);
+
+  RunCoroutine([&] -> asio::awaitable<void> {
+    for (auto _ : state) {
+      co_await ws.process_binary(frame);
+    }
+  });
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_ProcessSbeMessage)->ArgName("streams")->Arg(1)->Arg(16)->Arg(256);
+
+void BM_SubjectFanOut(benchmark::State& state) {
+  rpp::subjects::publish_subject<state::Trade> subject;
+  std::vector<double> sinks(state.range(0));
+  for (auto& sink : sinks) {
+    subject.get_observable().subscribe(
+        [&sink](const state::Trade& trade) { sink += trade.price; });
+  }
+  const auto trade =
+      nlohmann::json::parse(TradeData(12345)).get<state::Trade>();
+  for (auto _ : state) {
+    subject.get_observer().on_next(trade);
+  }
+  benchmark::DoNotOptimize(sinks.data());
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SubjectFanOut)->ArgName("subscribers")->Arg(1)->Arg(4)->Arg(16);
+
+// ---------------------------------------------------------------------------
+// Order entry.
+// ---------------------------------------------------------------------------
+
+constexpr std::string_view kApiKey =
+    "vmPUZE6mv9SD5VNHk4HlWFsOr6aKE2zvsw0MuIgwCIPy6utIco14y7Ju91duEh8A";
+constexpr std::string_view kApiSecret =
+    "NhqPtmdSJYdKjVHjA7PZj4Mge3R5YNiP1e3UZjInClVN65XAbvqqM6A7H5fATj0j";
+
+// Signed order.place as OrderEntry sends it: template patched in place.
+void BM_OrderPlaceTemplate(benchmark::State& state) {
+  asio::io_context io_context;
+  exchange::WebSocketAPI api(io_context);
+  exchange::HmacSigner signer(kApiSecret);
+  exchange::OrderEntry entry(api, {.symbol = "BTCUSDT"}, std::string(kApiKey),
+                             signer);
+  int id = 0;
+  for (auto _ : state) {
+    const auto request = entry.place_request(
+        ++id, exchange::Side::kBuy, 97123.45 + id % 100, 0.0015,
+        "order-12345", 1737000000000 + id);
+    benchmark::DoNotOptimize(request.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OrderPlaceTemplate);
+
+// The same request built as a JSON DOM and serialized, signed the same way.
+void BM_OrderPlaceJson(benchmark::State& state) {
+  exchange::HmacSigner signer(kApiSecret);
+  std::string signature(signer.signature_size(), '\0');
+  int id = 0;
+  for (auto _ : state) {
+    ++id;
+    const std::string price = std::format("{:.2f}", 97123.45 + id % 100);
+    const std::string quantity = std::format("{:.5f}", 0.0015);
+    const int64_t timestamp = 1737000000000 + id;
+    const std::string payload = std::format(
+        "apiKey={}&newClientOrderId=order-12345&newOrderRespType=ACK&"
+        "price={}&quantity={}&side=BUY&symbol=BTCUSDT&timeInForce=GTC&"
+        "timestamp={}&type=LIMIT",
+        kApiKey, price, quantity, timestamp);
+    signer.sign(payload, signature.data());
+    const nlohmann::json request = {
+        {"id", id},
+        {"method", "order.place"},
+        {"params",
+         {{"apiKey", kApiKey},
+          {"newClientOrderId", "order-12345"},
+          {"newOrderRespType", "ACK"},
+          {"price", price},
+          {"quantity", quantity},
+          {"side", "BUY"},
+          {"signature", signature},
+          {"symbol", "BTCUSDT"},
+          {"timeInForce", "GTC"},
+          {"timestamp", timestamp},
+          {"type", "LIMIT"}}}};
+    benchmark::DoNotOptimize(request.dump());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OrderPlaceJson);
+
+// HMAC-SHA256 from the precomputed key pads.
+void BM_HmacSign(benchmark::State& state) {
+  exchange::HmacSigner signer(kApiSecret);
+  const std::string payload(state.range(0), 'x');
+  std::string signature(signer.signature_size(), '\0');
+  for (auto _ : state) {
+    signer.sign(payload, signature.data());
+    benchmark::DoNotOptimize(signature.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HmacSign)->ArgName("bytes")->Arg(64)->Arg(256);
+
+// One-shot HMAC(), which derives the key pads on every call.
+void BM_HmacOneShot(benchmark::State& state) {
+  const std::string payload(state.range(0), 'x');
+  unsigned char digest[32];
+  for (auto _ : state) {
+    HMAC(EVP_sha256(), kApiSecret.data(), static_cast<int>(kApiSecret.size()),
+         reinterpret_cast<const unsigned char*>(payload.data()),
+         payload.size(), digest, nullptr);
+    benchmark::DoNotOptimize(digest);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HmacOneShot)->ArgName("bytes")->Arg(64)->Arg(256);
+
+// ---------------------------------------------------------------------------
+// Recorded payloads.
+// ---------------------------------------------------------------------------
+
+// Decodes the event without publishing it, so recorded depth streams do not
+// need a snapshot source.
+template <typename Event>
+class DecodeHandler final : public exchange::IStreamHandler {
+ public:
+  explicit DecodeHandler(std::string stream) : stream_(std::move(stream)) {}
+
+  std::string stream_name() const noexcept override { return stream_; }
+
+  asio::awaitable<void> handle(const nlohmann::json& data) override {
+    auto event = data.get<Event>();
+    benchmark::DoNotOptimize(event);
+    co_return;
+  }
+
+ private:
+  std::string stream_;
+};
+
+void RegisterRecorded(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    std::cerr << "cannot open payload file " << path << '\n';
+    return;
+  }
+  auto messages = std::make_shared<std::vector<std::string>>();
+  auto streams = std::make_shared<std::vector<std::string>>();
+  for (std::string line; std::getline(file, line);) {
+    if (line.empty()) continue;
+    const auto document = nlohmann::json::parse(line, nullptr, false);
+    if (document.is_discarded() || !document.contains("stream")) continue;
+    const auto stream = document["stream"].get<std::string>();
+    if (!stream.contains("@aggTrade") && !stream.contains("@depth")) continue;
+    if (!std::ranges::contains(*streams, stream)) streams->push_back(stream);
+    messages->push_back(std::move(line));
+  }
+  if (messages->empty()) {
+    std::cerr << "no aggTrade or depth messages in " << path << '\n';
+    return;
+  }
+  size_t bytes = 0;
+  for (const auto& message : *messages) bytes += message.size();
+
+  benchmark::RegisterBenchmark(
+      "BM_RecordedProcessMessage",
+      [messages, streams, bytes](benchmark::State& state) {
+        asio::io_context io_context;
+        exchange::WebSocketStreams ws(io_context);
+        for (const auto& stream : *streams) {
+          if (stream.contains("@aggTrade")) {
+            ws.register_handler(
+                stream, std::make_unique<DecodeHandler<state::Trade>>(stream));
+          } else {
+            ws.register_handler(
+                stream,
+                std::make_unique<DecodeHandler<state::OrderBookUpdate>>(
+                    stream));
+          }
+        }
+        RunCoroutine([&] -> asio::awaitable<void> {
+          for (auto _ : state) {
+            for (const auto& message : *messages) {
+              co_await ws.process_message(message);
+            }
+          }
+        });
+        state.SetItemsProcessed(state.iterations() * messages->size());
+        state.SetBytesProcessed(state.iterations() * bytes);
+      });
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  // Strip our own flag before Google Benchmark sees the command line.
+  std::vector<char*> args;
+  for (int i = 0; i < argc; ++i) {
+    constexpr std::string_view kPayloads = "--payloads=";
+    if (const std::string_view arg = argv[i]; arg.starts_with(kPayloads)) {
+      RegisterRecorded(std::string(arg.substr(kPayloads.size())));
+      continue;
+    }
+    args.push_back(argv[i]);
+  }
+  int args_count = static_cast<int>(args.size());
+  benchmark::Initialize(&args_count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(args_count, args.data())) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,279 @@
+// End-to-end feed benchmark against tools/mock_server, for choosing the Asio
+// backend per deployment. Build once normally (epoll) and once with
+// -DTERMINAL_ASIO_IO_URING=ON, then run both against the same server:
+//
+//   mock_server --stamp --trade-rate=20000 --depth-interval=10
+//   transport_feed --streams=wss://localhost:9443/stream --seconds=10 \
+//                  --insecure
+//
+// After a one second warm-up it reports messages and bytes per second,
+// syscalls per message, process CPU time per MB and the latency from the
+// server's send stamp ("sent_ns") to the handler. Syscalls are counted with
+// the raw_syscalls:sys_enter tracepoint, which needs tracefs access and a
+// permissive kernel.perf_event_paranoid; otherwise they are reported as n/a
+// (use `strace -c -f` instead).
+//
+// With --deflate (and mock_server --deflate) the connection negotiates
+// permessage-deflate; the report then adds the compression ratio and the
+// CPU time spent reading each message, to compare against a run without.
+//
+// Usage: transport_feed [--streams=wss://localhost:9443/stream]
+//                       [--seconds=10] [--markets=btcusdt,ethusdt]
+//                       [--deflate] [--insecure]
+//   --insecure  skip certificate checks (mock_server's is self-signed)
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "boost/asio/awaitable.hpp"
+#include "boost/asio/co_spawn.hpp"
+#include "boost/asio/detached.hpp"
+#include "boost/asio/io_context.hpp"
+#include "boost/asio/steady_timer.hpp"
+#include "boost/asio/use_awaitable.hpp"
+#include "nlohmann/json.hpp"
+#include "spdlog/spdlog.h"
+
+import exchange;
+import telemetry;
+
+namespace asio = boost::asio;
+
+namespace {
+struct Options {
+  exchange::Endpoint endpoint{"localhost", "9443", "/stream"};
+  int seconds = 10;
+  std::vector<std::string> markets{"btcusdt"};
+  bool deflate = false;
+};
+
+Options ParseOptions(const int argc, char* argv[]) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg.starts_with("--streams=")) {
+      const auto url = arg.substr(std::string_view("--streams=").size());
+      if (auto endpoint = exchange::parse_endpoint(url)) {
+        options.endpoint = *endpoint;
+      } else {
+        std::cerr << "invalid endpoint: " << url << '\n';
+      }
+    } else if (arg.starts_with("--seconds=")) {
+      const auto value = arg.substr(std::string_view("--seconds=").size());
+      std::from_chars(value.data(), value.data() + value.size(),
+                      options.seconds);
+    } else if (arg.starts_with("--markets=")) {
+      options.markets.clear();
+      for (const auto market :
+           arg.substr(std::string_view("--markets=").size()) |
+               std::views::split(',')) {
+        options.markets.emplace_back(std::string_view(market));
+      }
+    } else if (arg == "--deflate") {
+      options.deflate = true;
+    } else if (arg == "--insecure") {
+      exchange::set_tls_verification(false);
+    }
+  }
+  return options;
+}
+
+// Syscalls entered by this process, from the raw_syscalls:sys_enter
+// tracepoint.
+class SyscallCounter {
+ public:
+  SyscallCounter() {
+    for (const char* path :
+         {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+          "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"}) {
+      std::ifstream in(path);
+      uint64_t id = 0;
+      if (!(in >> id)) continue;
+      perf_event_attr attr{};
+      attr.type = PERF_TYPE_TRACEPOINT;
+      attr.size = sizeof(attr);
+      attr.config = id;
+      attr.inherit = 1;
+      fd_ = static_cast<int>(
+          ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+      if (fd_ >= 0) break;
+    }
+  }
+  ~SyscallCounter() {
+    if (fd_ >= 0) ::close(fd_);
+  }
+
+  [[nodiscard]] std::optional<uint64_t> read() const {
+    uint64_t count = 0;
+    if (fd_ < 0 || ::read(fd_, &count, sizeof(count)) != sizeof(count)) {
+      return std::nullopt;
+    }
+    return count;
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+int64_t CpuMicros() {
+  rusage usage{};
+  ::getrusage(RUSAGE_SELF, &usage);
+  const auto micros = [](const timeval& tv) {
+    return static_cast<int64_t>(tv.tv_sec) * 1'000'000 + tv.tv_usec;
+  };
+  return micros(usage.ru_utime) + micros(usage.ru_stime);
+}
+
+struct Sample {
+  uint64_t events = 0;
+  uint64_t bytes = 0;
+  uint64_t wire_bytes = 0;
+  std::optional<uint64_t> syscalls;
+  int64_t cpu_us = 0;
+};
+
+// Counts stream events and records their latency from the server's stamp.
+class StampedHandler final : public exchange::IStreamHandler {
+ public:
+  StampedHandler(std::string stream, telemetry::Histogram& latency,
+                 uint64_t& events)
+      : stream_(std::move(stream)), latency_(latency), events_(events) {}
+
+  [[nodiscard]] std::string stream_name() const noexcept override {
+    return stream_;
+  }
+
+  asio::awaitable<void> handle(const nlohmann::json& data) override {
+    const int64_t now = telemetry::now_ns();
+    ++events_;
+    if (const auto it = data.find("sent_ns"); it != data.end()) {
+      latency_.record(now - it->get<int64_t>());
+    }
+    co_return;
+  }
+
+ private:
+  std::string stream_;
+  telemetry::Histogram& latency_;
+  uint64_t& events_;
+};
+}  // namespace
+
+int main(const int argc, char* argv[]) {
+  const Options options = ParseOptions(argc, argv);
+  spdlog::set_level(spdlog::level::warn);
+
+  asio::io_context io_context;
+  exchange::WebSocketStreams ws(io_context, options.endpoint);
+  ws.set_deflate({.enabled = options.deflate});
+  const std::string host_label = R"(host=")" + options.endpoint.host + R"(")";
+  auto& bytes = telemetry::metrics().counter(
+      "ws_bytes_received_total", "WebSocket payload bytes received",
+      host_label);
+  auto& wire_bytes = telemetry::metrics().counter(
+      "ws_wire_bytes_received_total",
+      "TLS bytes received after the WebSocket handshake", host_label);
+  auto& read_cpu = telemetry::metrics().histogram(
+      "ws_read_cpu_seconds",
+      "Thread CPU time to decrypt, parse and inflate each message",
+      host_label);
+  telemetry::Histogram latency;
+  uint64_t events = 0;
+  SyscallCounter syscalls;
+  const auto sample = [&] {
+    return Sample{.events = events,
+                  .bytes = bytes.value(),
+                  .wire_bytes = wire_bytes.value(),
+                  .syscalls = syscalls.read(),
+                  .cpu_us = CpuMicros()};
+  };
+
+  asio::co_spawn(io_context, ws.run(), asio::detached);
+  asio::co_spawn(
+      io_context,
+      [&]() -> asio::awaitable<void> {
+        for (const auto& market : options.markets) {
+          co_await ws.subscribe(market, std::make_unique<StampedHandler>(
+                                            "aggTrade", latency, events));
+          co_await ws.subscribe(market, std::make_unique<StampedHandler>(
+                                            "depth@100ms", latency, events));
+        }
+      },
+      asio::detached);
+
+  Sample start;
+  Sample end;
+  asio::co_spawn(
+      io_context,
+      [&]() -> asio::awaitable<void> {
+        asio::steady_timer timer(io_context, std::chrono::seconds(1));
+        co_await timer.async_wait(asio::use_awaitable);
+        latency.reset();
+        read_cpu.reset();
+        start = sample();
+        timer.expires_after(std::chrono::seconds(options.seconds));
+        co_await timer.async_wait(asio::use_awaitable);
+        end = sample();
+        io_context.stop();
+      },
+      asio::detached);
+  io_context.run();
+
+  const uint64_t messages = end.events - start.events;
+  const double mb = static_cast<double>(end.bytes - start.bytes) / 1e6;
+  if (messages == 0) {
+    std::cerr << "no messages received; is mock_server running?\n";
+    return 1;
+  }
+  const auto us = [](const int64_t ns) {
+    return static_cast<double>(ns) / 1e3;
+  };
+  std::cout << std::format("backend:        {}\n", exchange::io_backend())
+            << std::format("messages:       {} ({:.0f}/s)\n", messages,
+                           static_cast<double>(messages) / options.seconds)
+            << std::format("throughput:     {:.2f} MB/s\n",
+                           mb / options.seconds);
+  if (start.syscalls && end.syscalls) {
+    std::cout << std::format(
+        "syscalls/msg:   {:.3f}\n",
+        static_cast<double>(*end.syscalls - *start.syscalls) / messages);
+  } else {
+    std::cout << "syscalls/msg:   n/a\n";
+  }
+  std::cout << std::format("cpu:            {:.1f} us/MB, {:.2f} us/msg\n",
+                           static_cast<double>(end.cpu_us - start.cpu_us) / mb,
+                           static_cast<double>(end.cpu_us - start.cpu_us) /
+                               messages);
+  std::cout << std::format(
+      "wire/payload:   {:.3f}\n",
+      static_cast<double>(end.wire_bytes - start.wire_bytes) /
+          static_cast<double>(end.bytes - start.bytes));
+  if (read_cpu.count() != 0) {
+    std::cout << std::format("read cpu (us):  p50 {:.2f}  p99 {:.2f}\n",
+                             us(read_cpu.percentile(0.5)),
+                             us(read_cpu.percentile(0.99)));
+  }
+  if (latency.count() != 0) {
+    std::cout << std::format(
+        "latency (us):   p50 {:.1f}  p99 {:.1f}  p99.9 {:.1f}  max {:.1f}\n",
+        us(latency.percentile(0.5)), us(latency.percentile(0.99)),
+        us(latency.percentile(0.999)), us(latency.max()));
+  } else {
+    std::cout << "latency:        n/a (start mock_server with --stamp)\n";
+  }
+  return 0;
+}
@@ -0,0 +1,308 @@
+// Headless frame-cost benchmark for the UI widgets.
+//
+// Renders each widget into an offscreen ftxui::Screen while synthetic trade
+// and order book streams are published between frames, and reports render
+// time percentiles, heap allocations per frame and terminal output bytes
+// (full repaint vs. damage-tracked diff). Events a table bus dropped are
+// reported too: a non-zero count means the tables were smaller than asked.
+//
+// Usage: ui_render [--frames=N] [--width=W] [--height=H] [--rows=N]
+//                  [--levels=N] [--trades-per-frame=N] [--history=N] [--json]
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ftxui/component/component.hpp"
+#include "ftxui/dom/node.hpp"
+#include "ftxui/screen/screen.hpp"
+#include "rpp/subjects/publish_subject.hpp"
+
+import state;
+import telemetry;
+import ui;
+import ui.component;
+import ui.widget;
+
+namespace {
+using rpp::subjects::publish_subject;
+
+struct Options {
+  int frames = 1000;
+  int width = 160;
+  int height = 50;
+  int rows = 10000;             // rows kept by the bare table
+  int levels = 5000;            // book levels per side
+  int trades_per_frame = 40;    // e.g. 2400 trades/s at 60 fps
+  int history = 20000;          // trades published before measuring
+  bool json = false;
+};
+
+Options ParseOptions(const int argc, char* argv[]) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const auto value_of = [&arg](const std::string_view name, int& out) {
+      if (!arg.starts_with(name) || arg.size() <= name.size() ||
+          arg[name.size()] != '=') {
+        return;
+      }
+      const auto value = arg.substr(name.size() + 1);
+      std::from_chars(value.data(), value.data() + value.size(), out);
+    };
+    value_of("--frames", options.frames);
+    value_of("--width", options.width);
+    value_of("--height", options.height);
+    value_of("--rows", options.rows);
+    value_of("--levels", options.levels);
+    value_of("--trades-per-frame", options.trades_per_frame);
+    value_of("--history", options.history);
+    if (arg == "--json") options.json = true;
+  }
+  return options;
+}
+
+// Synthetic market around a random-walking mid price.
+class SyntheticMarket {
+ public:
+  explicit SyntheticMarket(const int levels) : levels_(levels) {
+    Rebuild();
+  }
+
+  state::Trade NextTrade() {
+    mid_ += step_(rng_);
+    time_ += std::chrono::milliseconds(1);
+    return state::Trade{
+        .event_time = time_,
+        .symbol = "BTCUSDT",
+        .trade_id = ++trade_id_,
+        .price = mid_ + step_(rng_),
+        .quantity = size_(rng_),
+        .first_trade_id = trade_id_,
+        .last_trade_id = trade_id_,
+        .trade_time = time_,
+        .is_buyer_market_maker = (trade_id_ & 1) != 0,
+    };
+  }
+
+  // Change a few levels near the top of the book, like a depth diff.
+  const state::OrderBook& NextBook() {
+    std::uniform_int_distribution<int> near_top(0, std::min(levels_, 50) - 1);
+    for (int i = 0; i < 20; ++i) {
+      auto& side = (i & 1) ? book_.bids : book_.asks;
+      auto it = (i & 1) ? std::prev(side.end(), near_top(rng_) + 1)
+                        : std::next(side.begin(), near_top(rng_));
+      it->second.quantity = size_(rng_);
+    }
+    return book_;
+  }
+
+ private:
+  void Rebuild() {
+    for (int i = 1; i <= levels_; ++i) {
+      const double bid = mid_ - i * 0.01;
+      const double ask = mid_ + i * 0.01;
+      book_.bids[bid] = state::OrderBookEntry{bid, size_(rng_)};
+      book_.asks[ask] = state::OrderBookEntry{ask, size_(rng_)};
+    }
+  }
+
+  const int levels_;
+  std::mt19937_64 rng_{42};
+  std::normal_distribution<double> step_{0.0, 0.5};
+  std::exponential_distribution<double> size_{2.0};
+  double mid_ = 100000.0;
+  uint64_t trade_id_ = 0;
+  std::chrono::system_clock::time_point time_{};
+  state::OrderBook book_{};
+};
+
+// Bare table body: numbered rows, keeping the newest `capacity`.
+class CounterBody final : public component::TableBody<uint64_t, uint64_t> {
+ public:
+  CounterBody(const publish_subject<uint64_t>& input,
+              publish_subject<component::RedrawSignal>& output,
+              const size_t capacity)
+      : TableBody(input, output), capacity_(capacity) {}
+
+  void ProcessEvent(const uint64_t& event) override {
+    AppendRow(event);
+    EvictOldestWhile(
+        [this](uint64_t) { return rows_.size() > capacity_; });
+  }
+
+  [[nodiscard]] RowType BuildRow(const uint64_t& event) const override {
+    return {std::to_string(event), std::to_string(event * 7 % 1000),
+            std::to_string(event % 60)};
+  }
+
+ private:
+  const size_t capacity_;
+};
+
+// Events dropped by full table buses so far.
+uint64_t TableBusDrops() {
+  double dropped = 0;
+  for (const auto& sample : telemetry::metrics().snapshot()) {
+    if (sample.name == "table_events_dropped_total") dropped += sample.value;
+  }
+  return static_cast<uint64_t>(dropped);
+}
+
+// Render into a scratch screen, draining the widget's bus.
+void RenderOnce(const ftxui::Component& component, const Options& options) {
+  auto screen = ftxui::Screen::Create(ftxui::Dimension::Fixed(options.width),
+                                      ftxui::Dimension::Fixed(options.height));
+  ftxui::Render(screen, component->Render());
+}
+
+struct Result {
+  std::string name;
+  std::vector<double> micros;
+  uint64_t allocations = 0;
+  uint64_t bus_drops = 0;
+  uint64_t full_bytes = 0;
+  uint64_t diff_bytes = 0;
+  int frames = 0;
+};
+
+double Percentile(std::vector<double> values, const double p) {
+  if (values.empty()) return 0.0;
+  const auto index = static_cast<size_t>(p * (values.size() - 1));
+  std::ranges::nth_element(values, values.begin() + index);
+  return values[index];
+}
+
+template <typename Publish>
+Result Measure(const std::string& name, const ftxui::Component& component,
+               const Options& options, Publish&& publish) {
+  Result result{.name = name};
+  result.micros.reserve(options.frames);
+  ui::DamageTracker tracker;
+  const uint64_t drops_before = TableBusDrops();
+  auto screen = ftxui::Screen::Create(ftxui::Dimension::Fixed(options.width),
+                                      ftxui::Dimension::Fixed(options.height));
+  for (int frame = 0; frame < options.frames; ++frame) {
+    publish();  // outside the measured window, like the io thread
+
+    const uint64_t allocations_before = telemetry::allocation_count();
+    const auto start = std::chrono::steady_clock::now();
+    screen.Clear();
+    ftxui::Render(screen, component->Render());
+    const auto end = std::chrono::steady_clock::now();
+    result.allocations += telemetry::allocation_count() - allocations_before;
+    result.micros.push_back(
+        std::chrono::duration<double, std::micro>(end - start).count());
+
+    result.full_bytes += screen.ToString().size();
+    result.diff_bytes += tracker.Diff(screen).size();
+  }
+  result.frames = options.frames;
+  result.bus_drops = TableBusDrops() - drops_before;
+  return result;
+}
+
+void Report(const std::vector<Result>& results, const Options& options,
+            const uint64_t warmup_drops) {
+  if (options.json) {
+    std::cout << "[";
+    for (size_t i = 0; i < results.size(); ++i) {
+      const auto& r = results[i];
+      std::cout << std::format(
+          R"({}{{"widget":"{}","frames":{},"p50_us":{:.2f},"p99_us":{:.2f},)"
+          R"("allocs_per_frame":{:.1f},"full_bytes_per_frame":{:.0f},)"
+          R"("diff_bytes_per_frame":{:.0f},"bus_drops":{}}})",
+          i == 0 ? "" : ",", r.name, r.frames, Percentile(r.micros, 0.50),
+          Percentile(r.micros, 0.99),
+          static_cast<double>(r.allocations) / r.frames,
+          static_cast<double>(r.full_bytes) / r.frames,
+          static_cast<double>(r.diff_bytes) / r.frames, r.bus_drops);
+    }
+    std::cout << "]\n";
+    return;
+  }
+  std::cout << std::format(
+      "{}x{} screen, {} frames, {} levels/side, {} trades/frame, {} bus "
+      "drops during warm-up\n",
+      options.width, options.height, options.frames, options.levels,
+      options.trades_per_frame, warmup_drops);
+  std::cout << std::format(
+      "{:<16} {:>10} {:>10} {:>12} {:>12} {:>12} {:>10}\n", "widget",
+      "p50 us", "p99 us", "allocs/frame", "full B/frame", "diff B/frame",
+      "bus drops");
+  for (const auto& r : results) {
+    std::cout << std::format(
+        "{:<16} {:>10.2f} {:>10.2f} {:>12.1f} {:>12.0f} {:>12.0f} {:>10}\n",
+        r.name, Percentile(r.micros, 0.50), Percentile(r.micros, 0.99),
+        static_cast<double>(r.allocations) / r.frames,
+        static_cast<double>(r.full_bytes) / r.frames,
+        static_cast<double>(r.diff_bytes) / r.frames, r.bus_drops);
+  }
+}
+}  // namespace
+
+int main(const int argc, char* argv[]) {
+  const Options options = ParseOptions(argc, argv);
+  SyntheticMarket market(options.levels);
+
+  publish_subject<state::Trade> trade_subject;
+  publish_subject<state::OrderBook> order_book_subject;
+  publish_subject<std::vector<std::string>> header_subject;
+  publish_subject<component::RedrawSignal> redraw_subject;
+
+  publish_subject<uint64_t> counter_subject;
+  const auto table = std::make_shared<component::ScrollableTable>(
+      std::make_shared<component::TableHeader>(header_subject, redraw_subject),
+      std::make_shared<CounterBody>(counter_subject, redraw_subject,
+                                    options.rows),
+      redraw_subject);
+  const auto market_trades =
+      widget::MarketTrades(trade_subject, header_subject, redraw_subject);
+  const auto order_book = widget::OrderBook(order_book_subject, trade_subject,
+                                            header_subject, redraw_subject);
+  header_subject.get_observer().on_next(
+      {"Price (USDT)", "Amount (BTC)", "Time"});
+
+  const auto publish_trades = [&](const int count) {
+    for (int i = 0; i < count; ++i) {
+      trade_subject.get_observer().on_next(market.NextTrade());
+    }
+  };
+  uint64_t counter = 0;
+  const auto publish_rows = [&](const int count) {
+    for (int i = 0; i < count; ++i) {
+      counter_subject.get_observer().on_next(++counter);
+    }
+  };
+  // Fill the tables in batches that fit their buses (4096 events),
+  // rendering after each so the bodies drain them; publishing everything at
+  // once would drop all but the first 4096.
+  constexpr int kWarmupBatch = 1024;
+  for (int done = 0; done < options.rows; done += kWarmupBatch) {
+    publish_rows(std::min(kWarmupBatch, options.rows - done));
+    RenderOnce(table, options);
+  }
+  for (int done = 0; done < options.history; done += kWarmupBatch) {
+    publish_trades(std::min(kWarmupBatch, options.history - done));
+    RenderOnce(market_trades, options);
+  }
+  order_book_subject.get_observer().on_next(market.NextBook());
+  const uint64_t warmup_drops = TableBusDrops();
+
+  std::vector<Result> results;
+  results.push_back(Measure("ScrollableTable", table, options, [&] {
+    publish_rows(options.trades_per_frame);
+  }));
+  results.push_back(Measure("MarketTrades", market_trades, options,
+                            [&] { publish_trades(options.trades_per_frame); }));
+  results.push_back(Measure("OrderBook", order_book, options, [&] {
+    order_book_subject.get_observer().on_next(market.NextBook());
+  }));
+  Report(results, options, warmup_drops);
+  return 0;
+}
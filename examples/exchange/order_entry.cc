@@ -0,0 +1,67 @@
+// Places and cancels a few far-from-market orders over the WS API and logs
+// the send-to-ack latency of each. Meant for tools/mock_server:
+//   mock_server --api-secret=secret &
+//   BINANCE_API_KEY=key BINANCE_API_SECRET=secret \
+//       exchange_order_entry wss://localhost:9443/ws-api/v3
+// The endpoint is required. Hosts other than localhost are refused unless
+// `--live` is given, since the orders would be real. Local endpoints skip
+// certificate checks (mock_server's certificate is self-signed).
+#include <cstdlib>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "boost/asio/co_spawn.hpp"
+#include "boost/asio/detached.hpp"
+#include "boost/asio/io_context.hpp"
+#include "spdlog/spdlog.h"
+
+import exchange;
+
+int main(const int argc, char* argv[]) {
+  const char* api_key = std::getenv("BINANCE_API_KEY");
+  const char* secret = std::getenv("BINANCE_API_SECRET");
+  if (api_key == nullptr || secret == nullptr) {
+    spdlog::error("set BINANCE_API_KEY and BINANCE_API_SECRET");
+    return 1;
+  }
+  const auto endpoint =
+      argc > 1 ? exchange::parse_endpoint(argv[1]) : std::nullopt;
+  if (!endpoint) {
+    spdlog::error("usage: {} <wss://host:port/ws-api/v3> [--live]", argv[0]);
+    return 1;
+  }
+  const bool local = endpoint->host == "localhost" ||
+                     endpoint->host == "127.0.0.1" || endpoint->host == "::1";
+  if (local) {
+    exchange::set_tls_verification(false);
+  } else if (argc < 3 || std::string_view(argv[2]) != "--live") {
+    spdlog::error("{} is not local; pass --live to place real orders",
+                  endpoint->host);
+    return 1;
+  }
+
+  boost::asio::io_context io_context;
+  exchange::WebSocketAPI api(io_context, *endpoint);
+  exchange::HmacSigner signer(secret);
+  exchange::OrderEntry orders(api, {.symbol = "BTCUSDT"}, api_key, signer);
+  boost::asio::co_spawn(io_context, api.run(), boost::asio::detached);
+  boost::asio::co_spawn(
+      io_context,
+      [&] -> boost::asio::awaitable<void> {
+        for (int i = 0; i < 10; ++i) {
+          const std::string id = std::format("example-{}", i);
+          const auto placed =
+              co_await orders.place(exchange::Side::kBuy, 1000.0, 0.001, id);
+          const auto cancelled = co_await orders.cancel(id);
+          spdlog::info("{}: place {} in {} us, cancel {} in {} us", id,
+                       placed.status, placed.latency_ns / 1000,
+                       cancelled.status, cancelled.latency_ns / 1000);
+        }
+        io_context.stop();
+      },
+      boost::asio::detached);
+  io_context.run();
+  return 0;
+}
@@ -64,9 +64,13 @@ int main() {
 
   // Set up screen.
   auto screen = ftxui::ScreenInteractive::TerminalOutput();
-  redraw_subject.get_observable().subscribe([&screen](component::RedrawSignal) {
-    screen.PostEvent(ftxui::Event::Custom);
-  });
+  component::RenderScheduler render_scheduler(
+      component::FrameInterval(60),
+      [&screen] { screen.PostEvent(ftxui::Event::Custom); });
+  redraw_subject.get_observable().subscribe(
+      [&render_scheduler](const component::RedrawSignal signal) {
+        render_scheduler.Request(signal.dirty);
+      });
   const auto shutdown_handler = [&screen, &io_context] {
     screen.Exit();
     io_context.stop();
@@ -0,0 +1,74 @@
+#include "boost/asio/co_spawn.hpp"
+#include "boost/asio/detached.hpp"
+#include "boost/asio/io_context.hpp"
+#include "ftxui/component/component.hpp"
+#include "ftxui/component/screen_interactive.hpp"
+#include "rpp/subjects/publish_subject.hpp"
+#include "spdlog/sinks/basic_file_sink.h"
+#include "spdlog/spdlog.h"
+
+import exchange;
+import state;
+import ui.component;
+import ui.widget;
+
+int main() {
+  // Set up logging.
+  auto file_sink = spdlog::basic_logger_mt("logger", "logs/ui_watchlist.log");
+  spdlog::set_default_logger(std::move(file_sink));
+
+  // Set up IO components.
+  boost::asio::io_context io_context;
+  exchange::WebSocketStreams ws(io_context);
+  boost::asio::co_spawn(io_context, ws.run(), boost::asio::detached);
+
+  auto handler = std::make_unique<state::AllMarketTickerHandler>();
+  const auto subject = handler->get_subject();
+  boost::asio::co_spawn(
+      io_context,
+      [&ws, &handler] -> boost::asio::awaitable<void> {
+        co_await ws.subscribe("", std::move(handler));  // all markets
+        co_return;
+      },
+      boost::asio::detached);
+
+  // Set up UI components.
+  const rpp::subjects::publish_subject<std::vector<std::string>> header_subject;
+  rpp::subjects::publish_subject<component::RedrawSignal> redraw_subject;
+  const auto watchlist =
+      widget::Watchlist(subject, header_subject, redraw_subject);
+  header_subject.get_observer().on_next(
+      {"Symbol", "Last", "24h %", "Volume"});
+
+  // Set up screen.
+  auto screen = ftxui::ScreenInteractive::TerminalOutput();
+  component::RenderScheduler render_scheduler(
+      component::FrameInterval(30),
+      [&screen] { screen.PostEvent(ftxui::Event::Custom); });
+  redraw_subject.get_observable().subscribe(
+      [&render_scheduler](const component::RedrawSignal signal) {
+        render_scheduler.Request(signal.dirty);
+      });
+  const auto shutdown_handler = [&screen, &io_context] {
+    screen.Exit();
+    io_context.stop();
+  };
+  const auto ui_handler =
+      CatchEvent(watchlist, [&shutdown_handler](const ftxui::Event& event) {
+        if (event == ftxui::Event::Custom) return true;
+        if (event == ftxui::Event::Escape) {
+          shutdown_handler();
+          return true;
+        }
+        return false;
+      });
+
+  // Run IO & UI loops.
+  std::thread io_thread([&io_context] { io_context.run(); });
+  screen.Loop(ui_handler);  // run the UI loop in the main thread.
+
+  // Clean up.
+  shutdown_handler();  // in case user hits Ctrl+C instead of ESC.
+  io_thread.join();
+  return 0;
+}
@@ -0,0 +1,125 @@
+module;
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "boost/asio.hpp"
+#include "boost/asio/ssl.hpp"
+#include "openssl/ssl.h"
+#include "spdlog/spdlog.h"
+
+module exchange;
+
+namespace exchange {
+namespace {
+std::atomic<bool> g_tls_verification{true};
+
+struct SessionCache {
+  std::mutex mutex;
+  std::unordered_map<std::string, SSL_SESSION*> by_host;
+};
+
+SessionCache& session_cache() {
+  static SessionCache instance;
+  return instance;
+}
+
+// OpenSSL hands over each new session, including TLS 1.3 tickets that
+// arrive after the handshake. Returning 1 keeps the reference.
+int OnNewSession(SSL* ssl, SSL_SESSION* session) {
+  const char* host = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+  if (host == nullptr) return 0;
+  auto& [mutex, by_host] = session_cache();
+  std::lock_guard lock(mutex);
+  SSL_SESSION*& slot = by_host[host];
+  if (slot != nullptr) SSL_SESSION_free(slot);
+  slot = session;
+  return 1;
+}
+}  // namespace
+
+asio::awaitable<DnsCache::Results> DnsCache::resolve(const std::string& host,
+                                                     const std::string& port) {
+  const auto executor = co_await asio::this_coro::executor;
+  const std::string key = host + ":" + port;
+  {
+    std::lock_guard lock(mutex_);
+    if (const auto it = entries_.find(key); it != entries_.end()) {
+      Entry& entry = it->second;
+      if (!entry.refreshing &&
+          std::chrono::steady_clock::now() - entry.resolved > kTtl) {
+        entry.refreshing = true;
+        asio::co_spawn(executor, refresh(host, port), asio::detached);
+      }
+      co_return entry.results;
+    }
+  }
+  asio::ip::tcp::resolver resolver(executor);
+  auto results = co_await resolver.async_resolve(host, port,
+                                                 asio::use_awaitable);
+  std::lock_guard lock(mutex_);
+  entries_[key] = Entry{.results = results,
+                        .resolved = std::chrono::steady_clock::now()};
+  co_return results;
+}
+
+asio::awaitable<void> DnsCache::refresh(std::string host, std::string port) {
+  const std::string key = host + ":" + port;
+  asio::ip::tcp::resolver resolver(co_await asio::this_coro::executor);
+  try {
+    auto results = co_await resolver.async_resolve(host, port,
+                                                   asio::use_awaitable);
+    std::lock_guard lock(mutex_);
+    entries_[key] = Entry{.results = std::move(results),
+                          .resolved = std::chrono::steady_clock::now()};
+  } catch (const std::exception& e) {
+    // Keep serving the old addresses; retry on the next lookup.
+    spdlog::warn("DNS refresh for {} failed: {}", host, e.what());
+    std::lock_guard lock(mutex_);
+    entries_[key].refreshing = false;
+  }
+}
+
+DnsCache& dns_cache() {
+  static DnsCache instance;
+  return instance;
+}
+
+void set_tls_verification(const bool enabled) noexcept {
+  g_tls_verification.store(enabled, std::memory_order_relaxed);
+}
+
+bool tls_verification() noexcept {
+  return g_tls_verification.load(std::memory_order_relaxed);
+}
+
+asio::ssl::context& tls_context() {
+  static asio::ssl::context context = [] {
+    asio::ssl::context ctx(asio::ssl::context::tls_client);
+    ctx.set_default_verify_paths();  // Use system's trusted CA certificates.
+    ctx.set_verify_mode(asio::ssl::verify_peer);
+    SSL_CTX* native = ctx.native_handle();
+    // TLS 1.3 saves a round trip on full handshakes; 1.2 stays allowed.
+    SSL_CTX_set_min_proto_version(native, TLS1_2_VERSION);
+    // Sessions are kept in `session_cache` by server name rather than in
+    // OpenSSL's internal store, which does not look up client sessions.
+    SSL_CTX_set_session_cache_mode(
+        native, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(native, OnNewSession);
+    return ctx;
+  }();
+  return context;
+}
+
+void prepare_tls(SSL* ssl, const std::string& host) {
+  SSL_set_tlsext_host_name(ssl, host.c_str());
+  auto& [mutex, by_host] = session_cache();
+  std::lock_guard lock(mutex);
+  if (const auto it = by_host.find(host);
+      it != by_host.end() && SSL_SESSION_is_resumable(it->second)) {
+    SSL_set_session(ssl, it->second);
+  }
+}
+}  // namespace exchange
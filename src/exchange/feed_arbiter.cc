@@ -0,0 +1,191 @@
+module;
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "boost/asio/awaitable.hpp"
+#include "boost/asio/co_spawn.hpp"
+#include "boost/asio/deferred.hpp"
+#include "boost/asio/experimental/parallel_group.hpp"
+#include "boost/asio/this_coro.hpp"
+#include "boost/asio/use_awaitable.hpp"
+#include "nlohmann/json.hpp"
+
+module exchange;
+
+import sbe;
+import telemetry;
+
+namespace exchange {
+namespace {
+// Sequence number of a JSON stream event, if it has one.
+std::optional<int64_t> JsonSequence(const nlohmann::json& data) {
+  // `u` first: depth events also have an `a`, their asks.
+  for (const char* key : {"u", "a", "t"}) {
+    if (const auto it = data.find(key);
+        it != data.end() && it->is_number_integer()) {
+      return it->get<int64_t>();
+    }
+  }
+  return std::nullopt;
+}
+
+// Sequence number of an SBE frame, if it has one.
+std::optional<int64_t> SbeSequence(const std::string_view frame) {
+  const auto template_id = sbe::template_of(frame);
+  if (!template_id) return std::nullopt;
+  switch (*template_id) {
+    case sbe::TemplateId::kTrades:
+      if (const auto event = sbe::TradesEvent::wrap(frame);
+          event && !event->trades().empty()) {
+        int64_t last = std::numeric_limits<int64_t>::min();
+        for (const sbe::TradeEntry trade : event->trades()) {
+          last = std::max(last, trade.id());
+        }
+        return last;
+      }
+      break;
+    case sbe::TemplateId::kBestBidAsk:
+      if (const auto event = sbe::BestBidAskEvent::wrap(frame)) {
+        return event->book_update_id();
+      }
+      break;
+    case sbe::TemplateId::kDepthDiff:
+      if (const auto event = sbe::DepthDiffEvent::wrap(frame)) {
+        return event->last_book_update_id();
+      }
+      break;
+    case sbe::TemplateId::kDepthSnapshot:
+      break;
+  }
+  return std::nullopt;
+}
+
+// One arbitrated stream: its handler and what has been forwarded to it.
+class Arbitrated {
+ public:
+  Arbitrated(std::unique_ptr<IStreamHandler> handler, const std::string& stream,
+             const size_t feeds)
+      : handler_(std::move(handler)) {
+    metrics_.reserve(feeds);
+    for (size_t feed = 0; feed < feeds; ++feed) {
+      const std::string labels = R"(stream=")" + stream + R"(",feed=")" +
+                                 std::to_string(feed) + R"(")";
+      metrics_.push_back(FeedMetrics{
+          .wins = telemetry::metrics().counter(
+              "feed_wins_total", "Events a feed delivered first", labels),
+          .lag = telemetry::metrics().histogram(
+              "feed_lag_seconds",
+              "Arrival of a feed's copy after the first copy of an event",
+              labels),
+      });
+    }
+  }
+
+  [[nodiscard]] IStreamHandler& handler() const noexcept { return *handler_; }
+
+  // Whether `feed`'s copy of event `sequence` is the first to arrive. A win
+  // is counted for the feed; for a later copy its lag behind the first one.
+  bool first(const size_t feed, const std::optional<int64_t> sequence) {
+    if (!sequence) return feed == 0;
+    const int64_t now = telemetry::monotonic_ns();
+    if (!forwarded_.empty() && *sequence <= forwarded_.back().sequence) {
+      // The forwarded event that covered this one.
+      const auto it = std::ranges::lower_bound(forwarded_, *sequence, {},
+                                               &Forwarded::sequence);
+      if (it != forwarded_.end()) metrics_[feed].lag.record(now - it->at_ns);
+      return false;
+    }
+    forwarded_.push_back({.sequence = *sequence, .at_ns = now});
+    if (forwarded_.size() > kHistory) forwarded_.pop_front();
+    metrics_[feed].wins.add();
+    return true;
+  }
+
+ private:
+  struct FeedMetrics {
+    telemetry::Counter& wins;
+    telemetry::Histogram& lag;
+  };
+  struct Forwarded {
+    int64_t sequence;
+    int64_t at_ns;  // arrival of the first copy
+  };
+  // Recent enough to match the copies of a feed that lags by seconds.
+  static constexpr size_t kHistory = 4096;
+
+  std::unique_ptr<IStreamHandler> handler_;
+  std::vector<FeedMetrics> metrics_;  // by feed
+  std::deque<Forwarded> forwarded_;   // ascending sequence
+};
+
+// What one feed subscribes for an arbitrated stream.
+class Leg final : public IStreamHandler {
+ public:
+  Leg(std::shared_ptr<Arbitrated> stream, const size_t feed) noexcept
+      : stream_(std::move(stream)), feed_(feed) {}
+
+  [[nodiscard]] std::string stream_name() const noexcept override {
+    return stream_->handler().stream_name();
+  }
+
+  asio::awaitable<void> handle(const nlohmann::json& data) override {
+    if (stream_->first(feed_, JsonSequence(data))) {
+      co_await stream_->handler().handle(data);
+    }
+  }
+
+  asio::awaitable<void> handle_sbe(const std::string_view frame) override {
+    if (stream_->first(feed_, SbeSequence(frame))) {
+      co_await stream_->handler().handle_sbe(frame);
+    }
+  }
+
+ private:
+  std::shared_ptr<Arbitrated> stream_;
+  size_t feed_;
+};
+
+// A spawned subscription owning its arguments.
+asio::awaitable<void> Subscribe(WebSocketStreams& feed,
+                                const std::string market,
+                                std::unique_ptr<IStreamHandler> handler) {
+  co_await feed.subscribe(market, std::move(handler));
+}
+}  // namespace
+
+asio::awaitable<void> FeedArbiter::subscribe(
+    const std::string& market, std::unique_ptr<IStreamHandler> handler) {
+  const std::string stream = market.empty()
+                                 ? handler->stream_name()
+                                 : market + "@" + handler->stream_name();
+  const auto arbitrated =
+      std::make_shared<Arbitrated>(std::move(handler), stream, feeds_.size());
+  const auto executor = co_await asio::this_coro::executor;
+  using Op = decltype(asio::co_spawn(
+      executor, std::declval<asio::awaitable<void>>(), asio::deferred));
+  std::vector<Op> ops;
+  ops.reserve(feeds_.size());
+  for (size_t feed = 0; feed < feeds_.size(); ++feed) {
+    ops.push_back(asio::co_spawn(
+        executor,
+        Subscribe(*feeds_[feed], market,
+                  std::make_unique<Leg>(arbitrated, feed)),
+        asio::deferred));
+  }
+  const auto [order, errors] =
+      co_await asio::experimental::make_parallel_group(std::move(ops))
+          .async_wait(asio::experimental::wait_for_all(), asio::use_awaitable);
+  for (const std::exception_ptr& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+}
+}  // namespace exchange
@@ -0,0 +1,89 @@
+module;
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+
+#include "boost/asio/io_context.hpp"
+
+module exchange;
+
+import telemetry;
+
+namespace exchange {
+namespace {
+// Backoff steps, in consecutive idle polls.
+constexpr uint64_t kYieldAfter = 10'000;
+constexpr uint64_t kBlockAfter = 100'000;
+constexpr auto kBlockFor = std::chrono::microseconds(100);
+// Iterations between idle ratio updates (checking the clock every
+// iteration would cost more than the poll).
+constexpr uint64_t kReportEvery = 1 << 14;
+
+void CpuPause() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+}  // namespace
+
+std::string_view io_backend() noexcept {
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+  return "io_uring";
+#else
+  return "epoll";
+#endif
+}
+
+void run_polling(asio::io_context& ioc, const IdlePolicy idle) {
+  auto& metrics = telemetry::metrics();
+  auto& iterations_metric = metrics.counter(
+      "io_loop_iterations_total", "Polls of the io context (busy-poll mode)");
+  auto& idle_metric = metrics.counter("io_loop_idle_iterations_total",
+                                      "Polls that found no handler to run");
+  auto& idle_percent = metrics.gauge(
+      "io_loop_idle_percent", "Share of idle polls over the last ~16k polls");
+
+  uint64_t iterations = 0;
+  uint64_t idle_iterations = 0;
+  uint64_t idle_streak = 0;
+  while (!ioc.stopped()) {
+    const bool ran = ioc.poll() != 0;
+    ++iterations;
+    if (ran) {
+      idle_streak = 0;
+    } else {
+      ++idle_iterations;
+      ++idle_streak;
+      switch (idle) {
+        case IdlePolicy::kSpin:
+          break;
+        case IdlePolicy::kPause:
+          CpuPause();
+          break;
+        case IdlePolicy::kBackoff:
+          if (idle_streak < kYieldAfter) {
+            CpuPause();
+          } else if (idle_streak < kBlockAfter) {
+            std::this_thread::yield();
+          } else {
+            if (ioc.run_one_for(kBlockFor) != 0) idle_streak = 0;
+          }
+          break;
+      }
+    }
+    if (iterations == kReportEvery) {
+      iterations_metric.add(iterations);
+      idle_metric.add(idle_iterations);
+      idle_percent.set(static_cast<int64_t>(idle_iterations * 100 /
+                                            iterations));
+      iterations = 0;
+      idle_iterations = 0;
+    }
+  }
+  iterations_metric.add(iterations);
+  idle_metric.add(idle_iterations);
+}
+}  // namespace exchange
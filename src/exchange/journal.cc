@@ -0,0 +1,149 @@
+module;
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "spdlog/spdlog.h"
+
+module exchange;
+
+namespace exchange {
+namespace {
+// File header: magic followed by the format version.
+constexpr char kMagic[8] = {'B', 'T', 'J', 'R', 'N', 'L', '\0', '\0'};
+constexpr uint64_t kVersion = 1;
+constexpr size_t kHeaderSize = sizeof(kMagic) + sizeof(kVersion);
+
+constexpr size_t Align8(const size_t n) { return (n + 7) & ~size_t{7}; }
+
+[[noreturn]] void ThrowErrno(const std::string& what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+}  // namespace
+
+Journal::Journal(const std::string& path, const size_t chunk_size)
+    : chunk_size_(Align8(chunk_size)) {
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) ThrowErrno("open " + path);
+  reserve(kHeaderSize);
+  std::memcpy(data_, kMagic, sizeof(kMagic));
+  std::memcpy(data_ + sizeof(kMagic), &kVersion, sizeof(kVersion));
+  size_ = kHeaderSize;
+}
+
+Journal::~Journal() {
+  if (data_ != nullptr) ::munmap(data_, capacity_);
+  if (fd_ >= 0) {
+    // Drop the unused tail of the last chunk.
+    if (::ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+      spdlog::error("journal truncate failed: {}", std::strerror(errno));
+    }
+    ::close(fd_);
+  }
+}
+
+uint32_t Journal::open_connection(const std::string_view url) {
+  const uint32_t id = next_connection_id_++;
+  write(id, JournalKind::kConnection, url);
+  return id;
+}
+
+void Journal::append(const uint32_t connection_id,
+                     const std::string_view frame, const bool binary) {
+  write(connection_id, binary ? JournalKind::kBinaryFrame : JournalKind::kFrame,
+        frame);
+}
+
+void Journal::write(const uint32_t connection_id, const JournalKind kind,
+                    const std::string_view data) {
+  const auto now = std::chrono::system_clock::now().time_since_epoch();
+  const JournalRecord record{
+      .receive_ns =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(),
+      .connection_id = connection_id,
+      .kind = kind,
+      .size = static_cast<uint32_t>(data.size()),
+      .reserved = 0,
+  };
+  const size_t total = sizeof(record) + Align8(data.size());
+  reserve(size_ + total);
+  std::memcpy(data_ + size_, &record, sizeof(record));
+  std::memcpy(data_ + size_ + sizeof(record), data.data(), data.size());
+  // The padding is already zero: fresh file pages read as zeros.
+  size_ += total;
+}
+
+void Journal::reserve(const size_t bytes) {
+  if (bytes <= capacity_) return;
+  size_t capacity = capacity_;
+  while (capacity < bytes) capacity += chunk_size_;
+  if (::ftruncate(fd_, static_cast<off_t>(capacity)) != 0) {
+    ThrowErrno("journal grow");
+  }
+  void* mapping =
+      data_ == nullptr
+          ? ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                   0)
+          : ::mremap(data_, capacity_, capacity, MREMAP_MAYMOVE);
+  if (mapping == MAP_FAILED) ThrowErrno("journal map");
+  data_ = static_cast<char*>(mapping);
+  capacity_ = capacity;
+}
+
+JournalReader::JournalReader(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) ThrowErrno("open " + path);
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    ThrowErrno("stat " + path);
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ < kHeaderSize) {
+    ::close(fd);
+    throw std::runtime_error("not a journal: " + path);
+  }
+  void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) ThrowErrno("map " + path);
+  data_ = static_cast<const char*>(mapping);
+  ::madvise(mapping, size_, MADV_SEQUENTIAL);
+
+  uint64_t version = 0;
+  std::memcpy(&version, data_ + sizeof(kMagic), sizeof(version));
+  if (std::memcmp(data_, kMagic, sizeof(kMagic)) != 0 || version != kVersion) {
+    ::munmap(mapping, size_);
+    data_ = nullptr;
+    throw std::runtime_error("not a journal: " + path);
+  }
+}
+
+JournalReader::~JournalReader() {
+  if (data_ != nullptr) ::munmap(const_cast<char*>(data_), size_);
+}
+
+std::optional<JournalEntry> JournalReader::next() {
+  if (offset_ + sizeof(JournalRecord) > size_) return std::nullopt;
+  JournalEntry entry{};
+  std::memcpy(&entry.record, data_ + offset_, sizeof(JournalRecord));
+  // A zero kind is unwritten space left by a writer that did not shut down.
+  if (entry.record.kind != JournalKind::kConnection &&
+      entry.record.kind != JournalKind::kFrame &&
+      entry.record.kind != JournalKind::kBinaryFrame) {
+    return std::nullopt;
+  }
+  const size_t payload = offset_ + sizeof(JournalRecord);
+  if (payload + entry.record.size > size_) return std::nullopt;
+  entry.payload = std::string_view(data_ + payload, entry.record.size);
+  offset_ = payload + Align8(entry.record.size);
+  return entry;
+}
+}  // namespace exchange
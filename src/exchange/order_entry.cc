@@ -0,0 +1,287 @@
+module;
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "boost/asio/awaitable.hpp"
+#include "nlohmann/json.hpp"
+
+module exchange;
+
+import telemetry;
+
+namespace exchange {
+namespace {
+constexpr size_t kMaxClientOrderId = 36;
+constexpr size_t kMaxDecimal = 32;  // price and quantity text
+constexpr size_t kMaxInteger = 20;  // int64 text
+
+std::string_view SideName(const Side side) {
+  return side == Side::kBuy ? "BUY" : "SELL";
+}
+
+bool ValidClientOrderId(const std::string_view id) {
+  return !id.empty() && id.size() <= kMaxClientOrderId &&
+         std::ranges::all_of(id, [](const char c) {
+           return std::isalnum(static_cast<unsigned char>(c)) ||
+                  std::string_view("._:/-").contains(c);
+         });
+}
+
+// `value` with `decimals` digits after the point.
+std::string_view FormatDecimal(const double value, const int decimals,
+                               std::array<char, kMaxDecimal>& buffer) {
+  const auto [end, ec] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), value,
+                    std::chars_format::fixed, decimals);
+  if (ec != std::errc()) {
+    throw std::invalid_argument("order price or quantity out of range");
+  }
+  return {buffer.data(), end};
+}
+
+std::string_view FormatInteger(const int64_t value,
+                               std::array<char, kMaxInteger>& buffer) {
+  const auto [end, ec] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+  return {buffer.data(), end};
+}
+
+// Exchange time for the `timestamp` parameter, so a drifting local clock
+// does not push requests out of the exchange's receive window.
+int64_t ExchangeTimeMs() {
+  return (telemetry::now_ns() - telemetry::tracer().clock().offset_ns()) /
+         1'000'000;
+}
+}  // namespace
+
+size_t RequestTemplate::add_slot(const size_t width) {
+  slots_.push_back({.offset = text_.size(), .width = width});
+  text_.append(width, ' ');
+  return slots_.size() - 1;
+}
+
+char* RequestTemplate::fill(const size_t slot, const size_t size,
+                            const bool quoted) noexcept {
+  const auto [offset, width] = slots_[slot];
+  char* begin = text_.data() + offset;
+  std::memset(begin, ' ', width);
+  if (!quoted) return begin;
+  begin[0] = '"';
+  begin[size + 1] = '"';
+  return begin + 1;
+}
+
+void RequestTemplate::set_string(const size_t slot,
+                                 const std::string_view value) noexcept {
+  std::memcpy(fill(slot, value.size(), true), value.data(), value.size());
+}
+
+void RequestTemplate::set_number(const size_t slot,
+                                 const int64_t value) noexcept {
+  char* begin = fill(slot, 0, false);
+  std::to_chars(begin, begin + slots_[slot].width, value);
+}
+
+OrderEntry::OrderEntry(WebSocketAPI& api, OrderSpec spec, std::string api_key,
+                       RequestSigner& signer)
+    : api_(api),
+      spec_(std::move(spec)),
+      api_key_(std::move(api_key)),
+      signer_(signer),
+      place_latency_(telemetry::metrics().histogram(
+          "ws_api_request_seconds", "WS-API request round-trip time",
+          R"(method="order.place")")),
+      cancel_latency_(telemetry::metrics().histogram(
+          "ws_api_request_seconds", "WS-API request round-trip time",
+          R"(method="order.cancel")")) {
+  // Parameters in key order, like the signature payload. LIMIT orders ask
+  // for the ACK response, the first the exchange can send.
+  const size_t signature_width = signer_.signature_size() + 2;
+  auto& place = place_prototype_;
+  place.append(R"({"id":)");
+  place_slots_.id = place.add_slot(kMaxInteger);
+  place.append(R"(,"method":"order.place","params":{"apiKey":")" + api_key_ +
+               R"(","newClientOrderId":)");
+  place_slots_.client_order_id = place.add_slot(kMaxClientOrderId + 2);
+  place.append(R"(,"newOrderRespType":"ACK","price":)");
+  place_slots_.price = place.add_slot(kMaxDecimal + 2);
+  place.append(R"(,"quantity":)");
+  place_slots_.quantity = place.add_slot(kMaxDecimal + 2);
+  place.append(R"(,"side":)");
+  place_slots_.side = place.add_slot(6);
+  place.append(R"(,"signature":)");
+  place_slots_.signature = place.add_slot(signature_width);
+  place.append(R"(,"symbol":")" + spec_.symbol + R"(","timeInForce":")" +
+               spec_.time_in_force + R"(","timestamp":)");
+  place_slots_.timestamp = place.add_slot(kMaxInteger);
+  place.append(R"(,"type":"LIMIT"}})");
+
+  auto& cancel = cancel_prototype_;
+  cancel.append(R"({"id":)");
+  cancel_slots_.id = cancel.add_slot(kMaxInteger);
+  cancel.append(R"(,"method":"order.cancel","params":{"apiKey":")" +
+                api_key_ + R"(","origClientOrderId":)");
+  cancel_slots_.client_order_id = cancel.add_slot(kMaxClientOrderId + 2);
+  cancel.append(R"(,"signature":)");
+  cancel_slots_.signature = cancel.add_slot(signature_width);
+  cancel.append(R"(,"symbol":")" + spec_.symbol + R"(","timestamp":)");
+  cancel_slots_.timestamp = cancel.add_slot(kMaxInteger);
+  cancel.append("}}");
+
+  place_pool_.push_back(std::make_unique<RequestTemplate>(place_prototype_));
+  cancel_pool_.push_back(
+      std::make_unique<RequestTemplate>(cancel_prototype_));
+  payload_.reserve(256);
+}
+
+void OrderEntry::fill_place(RequestTemplate& request, const int id,
+                            const Side side, const double price,
+                            const double quantity,
+                            const std::string_view client_order_id,
+                            const int64_t timestamp_ms) {
+  if (!ValidClientOrderId(client_order_id)) {
+    throw std::invalid_argument("invalid client order id: " +
+                                std::string(client_order_id));
+  }
+  std::array<char, kMaxDecimal> price_buffer;
+  std::array<char, kMaxDecimal> quantity_buffer;
+  std::array<char, kMaxInteger> timestamp_buffer;
+  const auto price_text =
+      FormatDecimal(price, spec_.price_decimals, price_buffer);
+  const auto quantity_text =
+      FormatDecimal(quantity, spec_.quantity_decimals, quantity_buffer);
+  const auto timestamp_text = FormatInteger(timestamp_ms, timestamp_buffer);
+
+  payload_.assign("apiKey=")
+      .append(api_key_)
+      .append("&newClientOrderId=")
+      .append(client_order_id)
+      .append("&newOrderRespType=ACK&price=")
+      .append(price_text)
+      .append("&quantity=")
+      .append(quantity_text)
+      .append("&side=")
+      .append(SideName(side))
+      .append("&symbol=")
+      .append(spec_.symbol)
+      .append("&timeInForce=")
+      .append(spec_.time_in_force)
+      .append("&timestamp=")
+      .append(timestamp_text)
+      .append("&type=LIMIT");
+
+  request.set_number(place_slots_.id, id);
+  request.set_string(place_slots_.client_order_id, client_order_id);
+  request.set_string(place_slots_.price, price_text);
+  request.set_string(place_slots_.quantity, quantity_text);
+  request.set_string(place_slots_.side, SideName(side));
+  request.set_number(place_slots_.timestamp, timestamp_ms);
+  signer_.sign(payload_, request.fill(place_slots_.signature,
+                                      signer_.signature_size(), true));
+}
+
+void OrderEntry::fill_cancel(RequestTemplate& request, const int id,
+                             const std::string_view client_order_id,
+                             const int64_t timestamp_ms) {
+  if (!ValidClientOrderId(client_order_id)) {
+    throw std::invalid_argument("invalid client order id: " +
+                                std::string(client_order_id));
+  }
+  std::array<char, kMaxInteger> timestamp_buffer;
+  const auto timestamp_text = FormatInteger(timestamp_ms, timestamp_buffer);
+
+  payload_.assign("apiKey=")
+      .append(api_key_)
+      .append("&origClientOrderId=")
+      .append(client_order_id)
+      .append("&symbol=")
+      .append(spec_.symbol)
+      .append("&timestamp=")
+      .append(timestamp_text);
+
+  request.set_number(cancel_slots_.id, id);
+  request.set_string(cancel_slots_.client_order_id, client_order_id);
+  request.set_number(cancel_slots_.timestamp, timestamp_ms);
+  signer_.sign(payload_, request.fill(cancel_slots_.signature,
+                                      signer_.signature_size(), true));
+}
+
+std::unique_ptr<RequestTemplate> OrderEntry::acquire(
+    std::vector<std::unique_ptr<RequestTemplate>>& pool,
+    const RequestTemplate& prototype) {
+  if (pool.empty()) return std::make_unique<RequestTemplate>(prototype);
+  auto request = std::move(pool.back());
+  pool.pop_back();
+  return request;
+}
+
+asio::awaitable<OrderAck> OrderEntry::send(const RequestTemplate& request,
+                                           const int id,
+                                           telemetry::Histogram& latency) {
+  OrderAck ack;
+  try {
+    const ApiResponse response =
+        co_await api_.call(id, request.text(), kAckTimeout);
+    ack.latency_ns = response.rtt_ns;
+    latency.record(ack.latency_ns);
+    const auto& body = response.body;
+    ack.status = body.value("status", 0);
+    if (const auto result = body.find("result");
+        result != body.end() && result->is_object()) {
+      ack.order_id = result->value("orderId", int64_t{0});
+    }
+    if (const auto error = body.find("error");
+        error != body.end() && error->is_object()) {
+      ack.error = error->value("msg", std::string());
+    }
+  } catch (const std::exception& e) {
+    ack.error = e.what();
+  }
+  co_return ack;
+}
+
+asio::awaitable<OrderAck> OrderEntry::place(
+    const Side side, const double price, const double quantity,
+    const std::string_view client_order_id) {
+  auto request = acquire(place_pool_, place_prototype_);
+  const int id = api_.next_request_id();
+  fill_place(*request, id, side, price, quantity, client_order_id,
+             ExchangeTimeMs());
+  OrderAck ack = co_await send(*request, id, place_latency_);
+  place_pool_.push_back(std::move(request));
+  co_return ack;
+}
+
+asio::awaitable<OrderAck> OrderEntry::cancel(
+    const std::string_view client_order_id) {
+  auto request = acquire(cancel_pool_, cancel_prototype_);
+  const int id = api_.next_request_id();
+  fill_cancel(*request, id, client_order_id, ExchangeTimeMs());
+  OrderAck ack = co_await send(*request, id, cancel_latency_);
+  cancel_pool_.push_back(std::move(request));
+  co_return ack;
+}
+
+std::string_view OrderEntry::place_request(
+    const int id, const Side side, const double price, const double quantity,
+    const std::string_view client_order_id, const int64_t timestamp_ms) {
+  fill_place(place_prototype_, id, side, price, quantity, client_order_id,
+             timestamp_ms);
+  return place_prototype_.text();
+}
+
+std::string_view OrderEntry::cancel_request(
+    const int id, const std::string_view client_order_id,
+    const int64_t timestamp_ms) {
+  fill_cancel(cancel_prototype_, id, client_order_id, timestamp_ms);
+  return cancel_prototype_.text();
+}
+}  // namespace exchange
@@ -0,0 +1,107 @@
+module;
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "openssl/bio.h"
+#include "openssl/evp.h"
+#include "openssl/pem.h"
+
+module exchange;
+
+namespace exchange {
+namespace {
+constexpr size_t kSha256BlockSize = 64;
+constexpr size_t kSha256Size = 32;
+
+MdCtx NewMdCtx() {
+  MdCtx ctx(EVP_MD_CTX_new());
+  if (!ctx) throw std::runtime_error("EVP_MD_CTX_new failed");
+  return ctx;
+}
+
+// A SHA-256 context that has hashed `key ^ pad`.
+MdCtx PaddedKeyHash(const std::array<unsigned char, kSha256BlockSize>& key,
+                    const unsigned char pad) {
+  std::array<unsigned char, kSha256BlockSize> block;
+  for (size_t i = 0; i < block.size(); ++i) block[i] = key[i] ^ pad;
+  MdCtx ctx = NewMdCtx();
+  if (EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr) != 1 ||
+      EVP_DigestUpdate(ctx.get(), block.data(), block.size()) != 1) {
+    throw std::runtime_error("SHA-256 init failed");
+  }
+  return ctx;
+}
+}  // namespace
+
+HmacSigner::HmacSigner(const std::string_view secret) {
+  // RFC 2104: keys longer than a block are hashed first, shorter ones are
+  // zero padded.
+  std::array<unsigned char, kSha256BlockSize> key{};
+  if (secret.size() > key.size()) {
+    unsigned int size = 0;
+    if (EVP_Digest(secret.data(), secret.size(), key.data(), &size,
+                   EVP_sha256(), nullptr) != 1) {
+      throw std::runtime_error("SHA-256 of the API secret failed");
+    }
+  } else {
+    std::memcpy(key.data(), secret.data(), secret.size());
+  }
+  inner_ = PaddedKeyHash(key, 0x36);
+  outer_ = PaddedKeyHash(key, 0x5c);
+  scratch_ = NewMdCtx();
+}
+
+void HmacSigner::sign(const std::string_view payload, char* out) {
+  std::array<unsigned char, kSha256Size> digest;
+  // Copying into a context of the same digest reuses its buffers.
+  EVP_MD_CTX_copy_ex(scratch_.get(), inner_.get());
+  EVP_DigestUpdate(scratch_.get(), payload.data(), payload.size());
+  EVP_DigestFinal_ex(scratch_.get(), digest.data(), nullptr);
+  EVP_MD_CTX_copy_ex(scratch_.get(), outer_.get());
+  EVP_DigestUpdate(scratch_.get(), digest.data(), digest.size());
+  EVP_DigestFinal_ex(scratch_.get(), digest.data(), nullptr);
+
+  constexpr char kHex[] = "0123456789abcdef";
+  for (const unsigned char byte : digest) {
+    *out++ = kHex[byte >> 4];
+    *out++ = kHex[byte & 0xf];
+  }
+}
+
+Ed25519Signer::Ed25519Signer(const std::string& pem_path) {
+  BIO* file = BIO_new_file(pem_path.c_str(), "r");
+  if (file == nullptr) {
+    throw std::runtime_error("cannot open Ed25519 key " + pem_path);
+  }
+  key_.reset(PEM_read_bio_PrivateKey(file, nullptr, nullptr, nullptr));
+  BIO_free(file);
+  if (!key_ || EVP_PKEY_id(key_.get()) != EVP_PKEY_ED25519) {
+    throw std::runtime_error(pem_path + " is not an Ed25519 private key");
+  }
+  ctx_ = NewMdCtx();
+}
+
+void Ed25519Signer::sign(const std::string_view payload, char* out) {
+  // Ed25519 hashes the message twice, so there is no midstate to keep; the
+  // parsed key and the context are what is reused.
+  std::array<unsigned char, 64> signature;
+  size_t size = signature.size();
+  EVP_MD_CTX_reset(ctx_.get());
+  if (EVP_DigestSignInit(ctx_.get(), nullptr, nullptr, nullptr,
+                         key_.get()) != 1 ||
+      EVP_DigestSign(ctx_.get(), signature.data(), &size,
+                     reinterpret_cast<const unsigned char*>(payload.data()),
+                     payload.size()) != 1) {
+    throw std::runtime_error("Ed25519 signing failed");
+  }
+  // EVP_EncodeBlock appends a terminating NUL.
+  std::array<unsigned char, 89> base64;
+  EVP_EncodeBlock(base64.data(), signature.data(),
+                  static_cast<int>(signature.size()));
+  std::memcpy(out, base64.data(), 88);
+}
+}  // namespace exchange
@@ -1,87 +1,281 @@
 module;
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <iostream>
+#include <optional>
 #include <shared_mutex>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "boost/asio.hpp"
 #include "boost/asio/awaitable.hpp"
+#include "boost/asio/bind_immediate_executor.hpp"
+#include "boost/asio/redirect_error.hpp"
 #include "boost/asio/ssl.hpp"
-#include "boost/beast/core/buffers_to_string.hpp"
 #include "boost/beast/core/flat_buffer.hpp"
 #include "boost/beast/ssl.hpp"
 #include "boost/beast/websocket/ssl.hpp"
 #include "boost/beast/websocket/stream.hpp"
 #include "boost/utility/string_view_fwd.hpp"
 #include "nlohmann/json.hpp"
+#include "openssl/bio.h"
 #include "openssl/ssl.h"
 #include "spdlog/spdlog.h"
 
 module exchange;
 
+import telemetry;
+
 namespace exchange {
 namespace asio = boost::asio;
 namespace beast = boost::beast;
 
-WebSocket::WebSocket(asio::io_context& ioc, const std::string& host,
-                     const std::string& port, const std::string& target)
-    : host_(host),
-      port_(port),
-      target_(target),
-      ssl_ctx_(asio::ssl::context::tlsv12_client),
-      resolver_(ioc),
-      ws_(ioc, ssl_ctx_) {
-  ssl_ctx_.set_default_verify_paths();  // Use system's trusted CA certificates.
+namespace {
+// Logged from the control callback, on the thread reading market data.
+const telemetry::LogSite kPongSent(telemetry::LogLevel::kInfo,
+                                   "ping received, pong sent");
+const telemetry::LogSite kPongFailed(telemetry::LogLevel::kError,
+                                     "Error sending pong: {}");
+
+// Executor for the completion handler of a read, metering on `meter` the CPU
+// time of everything run through it. Composed operations run their
+// intermediate steps (TLS decryption, frame parsing, inflate) on the
+// handler's executor, so this separates the read path from whatever else
+// the io thread does while a read is pending, busy polling included.
+template <typename Inner>
+class MeteredExecutor {
+ public:
+  MeteredExecutor(Inner inner, CpuMeter* meter) noexcept
+      : inner_(std::move(inner)), meter_(meter) {}
+
+  template <typename Function>
+  void execute(Function&& f) const {
+    inner_.execute(
+        [meter = meter_, f = std::forward<Function>(f)]() mutable {
+          if (meter->depth++ == 0) meter->open();
+          std::move(f)();
+          if (--meter->depth == 0) meter->close();
+        });
+  }
+
+  template <typename Property>
+  auto query(const Property& p) const
+      -> decltype(asio::query(std::declval<const Inner&>(), p)) {
+    return asio::query(inner_, p);
+  }
+
+  template <typename Property>
+  auto require(const Property& p) const
+      -> MeteredExecutor<std::decay_t<decltype(asio::require(
+          std::declval<const Inner&>(), p))>> {
+    return {asio::require(inner_, p), meter_};
+  }
+
+  template <typename Property>
+  auto prefer(const Property& p) const
+      -> MeteredExecutor<std::decay_t<decltype(asio::prefer(
+          std::declval<const Inner&>(), p))>> {
+    return {asio::prefer(inner_, p), meter_};
+  }
+
+  bool operator==(const MeteredExecutor&) const noexcept = default;
+
+ private:
+  Inner inner_;
+  CpuMeter* meter_;
+};
+}  // namespace
+
+std::optional<Endpoint> parse_endpoint(std::string_view url) {
+  constexpr std::string_view kScheme = "wss://";
+  if (!url.starts_with(kScheme)) return std::nullopt;
+  url.remove_prefix(kScheme.size());
+
+  const auto slash = url.find('/');
+  const std::string_view authority = url.substr(0, slash);
+  Endpoint endpoint{.target = "/"};
+  if (slash != std::string_view::npos) endpoint.target = url.substr(slash);
+  if (const auto colon = authority.find(':');
+      colon != std::string_view::npos) {
+    endpoint.host = authority.substr(0, colon);
+    endpoint.port = authority.substr(colon + 1);
+  } else {
+    endpoint.host = authority;
+    endpoint.port = "443";
+  }
+  if (endpoint.host.empty() || endpoint.port.empty()) return std::nullopt;
+  return endpoint;
+}
+
+WebSocket::WebSocket(asio::io_context& ioc, Endpoint endpoint)
+    : ioc_(ioc),
+      endpoint_(std::move(endpoint)),
+      connected_signal_(ioc, asio::steady_timer::time_point::max()),
+      send_signal_(ioc, asio::steady_timer::time_point::max()),
+      frames_metric_(telemetry::metrics().counter(
+          "ws_frames_received_total", "WebSocket frames received",
+          R"(host=")" + endpoint_.host + R"(")")),
+      bytes_metric_(telemetry::metrics().counter(
+          "ws_bytes_received_total", "WebSocket payload bytes received",
+          R"(host=")" + endpoint_.host + R"(")")),
+      reconnects_metric_(telemetry::metrics().counter(
+          "ws_reconnects_total", "WebSocket reconnections",
+          R"(host=")" + endpoint_.host + R"(")")),
+      tls_resumed_metric_(telemetry::metrics().counter(
+          "ws_tls_resumed_total", "TLS handshakes that resumed a session",
+          R"(host=")" + endpoint_.host + R"(")")),
+      first_message_metric_(telemetry::metrics().histogram(
+          "ws_first_message_seconds",
+          "Time from the start of a connection attempt to its first frame",
+          R"(host=")" + endpoint_.host + R"(")")),
+      deflate_metric_(telemetry::metrics().gauge(
+          "ws_deflate_active", "1 if permessage-deflate was negotiated",
+          R"(host=")" + endpoint_.host + R"(")")),
+      wire_bytes_metric_(telemetry::metrics().counter(
+          "ws_wire_bytes_received_total",
+          "TLS bytes received after the WebSocket handshake",
+          R"(host=")" + endpoint_.host + R"(")")),
+      compression_ratio_metric_(telemetry::metrics().gauge(
+          "ws_compression_ratio_percent",
+          "Payload bytes per 100 TLS bytes on the current connection",
+          R"(host=")" + endpoint_.host + R"(")")),
+      read_cpu_metric_(telemetry::metrics().histogram(
+          "ws_read_cpu_seconds",
+          "Thread CPU time to decrypt, parse and inflate each message",
+          R"(host=")" + endpoint_.host + R"(")")) {
+  constexpr std::array<const char*, static_cast<size_t>(Phase::kCount)>
+      kPhaseNames = {"resolve", "connect", "tls", "handshake"};
+  for (size_t i = 0; i < kPhaseNames.size(); ++i) {
+    phase_metrics_[i] = &telemetry::metrics().histogram(
+        "ws_connect_phase_seconds", "Duration of each connection setup phase",
+        std::string(R"(host=")") + endpoint_.host + R"(",phase=")" +
+            kPhaseNames[i] + R"(")");
+  }
+  ws_.emplace(ioc_, tls_context());
 }
 
 asio::awaitable<void> WebSocket::wait_for_connection() const {
-  const auto executor = co_await asio::this_coro::executor;
   while (!connected_) {
-    // Wait briefly before checking again.
-    asio::steady_timer timer(executor, std::chrono::milliseconds(50));
-    co_await timer.async_wait(asio::use_awaitable);
+    // Woken by `establish_connection` cancelling the signal.
+    boost::system::error_code ec;
+    co_await connected_signal_.async_wait(
+        asio::redirect_error(asio::use_awaitable, ec));
   }
   co_return;
 }
 
 asio::awaitable<void> WebSocket::establish_connection() {
   try {
-    auto executor = co_await asio::this_coro::executor;
-
-    // Resolve the hostname.
-    auto endpoints =
-        co_await resolver_.async_resolve(host_, port_, asio::use_awaitable);
+    connect_start_ = std::chrono::steady_clock::now();
+    auto phase_start = connect_start_;
+    const auto phase_done = [this, &phase_start](const Phase phase) {
+      const auto now = std::chrono::steady_clock::now();
+      phase_metrics_[static_cast<size_t>(phase)]->record(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(now -
+                                                               phase_start)
+              .count());
+      phase_start = now;
+    };
 
-    // Connect to one of the resolved endpoints.
-    co_await async_connect(ws_.next_layer().next_layer(), endpoints,
-                           asio::use_awaitable);
+    // Resolve the hostname (cached across connections).
+    const auto endpoints =
+        co_await dns_cache().resolve(endpoint_.host, endpoint_.port);
+    phase_done(Phase::kResolve);
 
-    // Perform the SSL handshake.
-    co_await ws_.next_layer().async_handshake(asio::ssl::stream_base::client,
-                                              asio::use_awaitable);
+    // Connect to one of the resolved endpoints, the preferred one first.
+    std::vector<asio::ip::tcp::endpoint> addresses;
+    for (const auto& entry : endpoints) addresses.push_back(entry.endpoint());
+    if (!addresses.empty()) {
+      std::ranges::rotate(addresses,
+                          addresses.begin() +
+                              static_cast<std::ptrdiff_t>(
+                                  preferred_address_ % addresses.size()));
+    }
+    auto& socket = ws_->next_layer().next_layer();
+    co_await async_connect(socket, addresses, asio::use_awaitable);
+    socket.set_option(asio::ip::tcp::no_delay(true));
+    phase_done(Phase::kConnect);
 
-    // Set SNI hostname.
-    SSL_set_tlsext_host_name(ws_.next_layer().native_handle(), host_.c_str());
+    // Perform the SSL handshake; SNI and any cached session go first. The
+    // certificate must be valid for the host we asked for.
+    auto& tls = ws_->next_layer();
+    if (tls_verification()) {
+      tls.set_verify_mode(asio::ssl::verify_peer);
+      tls.set_verify_callback(
+          asio::ssl::host_name_verification(endpoint_.host));
+    } else {
+      tls.set_verify_mode(asio::ssl::verify_none);
+    }
+    SSL* ssl = tls.native_handle();
+    prepare_tls(ssl, endpoint_.host);
+    co_await ws_->next_layer().async_handshake(asio::ssl::stream_base::client,
+                                               asio::use_awaitable);
+    if (SSL_session_reused(ssl) == 1) tls_resumed_metric_.add();
+    phase_done(Phase::kTls);
 
     // Perform the WebSocket handshake.
-    co_await ws_.async_handshake(host_, target_, asio::use_awaitable);
+    if (!api_key_.empty()) {
+      ws_->set_option(websocket::stream_base::decorator(
+          [key = api_key_](websocket::request_type& request) {
+            request.set("X-MBX-APIKEY", key);
+          }));
+    }
+    if (deflate_.enabled) {
+      websocket::permessage_deflate pmd;
+      pmd.client_enable = true;
+      pmd.server_max_window_bits = deflate_.server_max_window_bits;
+      pmd.client_max_window_bits = deflate_.client_max_window_bits;
+      pmd.server_no_context_takeover = deflate_.server_no_context_takeover;
+      pmd.client_no_context_takeover = deflate_.client_no_context_takeover;
+      // Requests are small; compressing them costs more than it saves.
+      pmd.msg_size_threshold = 1024;
+      ws_->set_option(pmd);
+    }
+    websocket::response_type response;
+    co_await ws_->async_handshake(response, endpoint_.host, endpoint_.target,
+                                  asio::use_awaitable);
+    phase_done(Phase::kHandshake);
+    const auto field = response[beast::http::field::sec_websocket_extensions];
+    const std::string_view extensions(field.data(), field.size());
+    const bool deflate = extensions.contains("permessage-deflate");
+    deflate_metric_.set(deflate ? 1 : 0);
+    if (deflate_.enabled && !deflate) {
+      spdlog::warn("{} declined permessage-deflate", endpoint_.host);
+    }
+    // Handshake bytes are not payload: start the ratio after them.
+    tls_bytes_read_ = BIO_number_read(SSL_get_rbio(ssl));
+    wire_bytes_ = 0;
+    payload_bytes_ = 0;
 
     // Set up a control callback to handle ping frames.
-    ws_.control_callback([this](const boost::beast::websocket::frame_type kind,
+    ws_->control_callback([this](const boost::beast::websocket::frame_type kind,
                                 const boost::string_view payload) {
       if (kind == boost::beast::websocket::frame_type::ping) {
         try {
           // Construct a ping_data object from the payload.
           const boost::beast::websocket::ping_data pd{std::string(payload)};
-          ws_.pong(pd);
-          spdlog::info("ping received, pong sent");
+          ws_->pong(pd);
+          telemetry::log(kPongSent);
         } catch (const std::exception& e) {
-          spdlog::error("Error sending pong: {}", e.what());
+          telemetry::log(kPongFailed, e.what());
         }
       }
     });
 
-    // Mark connection as established.
+    // Mark connection as established and wake the waiters.
     connected_ = true;
-    spdlog::info("connection established");
+    connected_signal_.cancel();
+    spdlog::info(
+        "connection to {} ({}) established in {} us (TLS session {})",
+        endpoint_.host, socket.remote_endpoint().address().to_string(),
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - connect_start_)
+            .count(),
+        SSL_session_reused(ssl) == 1 ? "resumed" : "new");
+    if (deflate) spdlog::info("{} extensions: {}", endpoint_.host, extensions);
   } catch (std::exception& e) {
     spdlog::error("exception in establish_connection: {}", e.what());
   }
@@ -89,17 +283,102 @@ asio::awaitable<void> WebSocket::establish_connection() {
 }
 
 asio::awaitable<void> WebSocket::run() {
-  co_await establish_connection();
+  constexpr auto kReconnectDelay = std::chrono::seconds(1);
+  bool reconnecting = false;
   while (true) {
-    beast::flat_buffer buffer;
-    co_await ws_.async_read(buffer, asio::use_awaitable);
-    std::string message = beast::buffers_to_string(buffer.data());
-    co_await process_message(message);
+    co_await establish_connection();
+    if (connected_) {
+      if (journal_ != nullptr) {
+        journal_connection_id_ = journal_->open_connection(
+            "wss://" + endpoint_.host + ":" + endpoint_.port +
+            endpoint_.target);
+      }
+      if (reconnecting) {
+        reconnects_metric_.add();
+        co_await on_reconnect();
+      }
+      try {
+        bool first = true;
+        // Reused for every message: once it has grown to the largest one,
+        // frames are read and inflated into it without allocating.
+        beast::flat_buffer buffer;
+        SSL* ssl = ws_->next_layer().native_handle();
+        const MeteredExecutor metered(ioc_.get_executor(), &read_cpu_);
+        const auto read_token = asio::bind_immediate_executor(
+            asio::require(metered, asio::execution::blocking.never),
+            asio::bind_executor(metered, asio::use_awaitable));
+        read_cpu_.take();
+        while (true) {
+          buffer.clear();
+          // Frames already buffered are parsed and inflated when the read
+          // starts, so meter that too if the last read resumed us.
+          if (read_cpu_.depth > 0) read_cpu_.open();
+          co_await ws_->async_read(buffer, read_token);
+          read_cpu_.close();
+          read_cpu_metric_.record(read_cpu_.take());
+          if (first) {
+            first = false;
+            first_message_metric_.record(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - connect_start_)
+                    .count());
+          }
+          auto& tracer = telemetry::tracer();
+          tracer.begin_message(telemetry::now_ns());
+          frames_metric_.add();
+          bytes_metric_.add(buffer.size());
+          const uint64_t tls_bytes_read = BIO_number_read(SSL_get_rbio(ssl));
+          wire_bytes_metric_.add(tls_bytes_read - tls_bytes_read_);
+          wire_bytes_ += tls_bytes_read - tls_bytes_read_;
+          tls_bytes_read_ = tls_bytes_read;
+          payload_bytes_ += buffer.size();
+          if (wire_bytes_ != 0) {
+            compression_ratio_metric_.set(
+                static_cast<int64_t>(payload_bytes_ * 100 / wire_bytes_));
+          }
+          const auto data = buffer.cdata();
+          const std::string_view frame(static_cast<const char*>(data.data()),
+                                       data.size());
+          if (journal_ != nullptr) {
+            journal_->append(journal_connection_id_, frame,
+                             ws_->got_binary());
+          }
+          if (ws_->got_binary()) {
+            // Decoded in place from the read buffer.
+            co_await process_binary(frame);
+          } else {
+            co_await process_message(frame);
+          }
+          tracer.end_message();
+        }
+      } catch (const std::exception& e) {
+        spdlog::warn("connection to {} lost: {}", endpoint_.host, e.what());
+      }
+      connected_ = false;
+      on_disconnect();
+    }
+
+    // An SSL stream cannot be reused once shut down: start from a fresh one.
+    asio::steady_timer timer(ioc_, kReconnectDelay);
+    co_await timer.async_wait(asio::use_awaitable);
+    ws_.emplace(ioc_, tls_context());
+    reconnecting = true;
   }
 }
 
-asio::awaitable<void> WebSocket::send_json(const std::string& message) {
-  co_await ws_.async_write(boost::asio::buffer(message), asio::use_awaitable);
-  co_return;
+asio::awaitable<void> WebSocket::send_json(const std::string_view message) {
+  while (sending_) {
+    // Woken by the write in progress cancelling the signal.
+    boost::system::error_code ec;
+    co_await send_signal_.async_wait(
+        asio::redirect_error(asio::use_awaitable, ec));
+  }
+  sending_ = true;
+  boost::system::error_code ec;
+  co_await ws_->async_write(asio::buffer(message.data(), message.size()),
+                            asio::redirect_error(asio::use_awaitable, ec));
+  sending_ = false;
+  send_signal_.cancel();
+  if (ec) throw boost::system::system_error(ec);
 }
 }  // namespace exchange
@@ -1,9 +1,11 @@
 module;
 #include <atomic>
-#include <future>
+#include <optional>
 #include <ranges>
 #include <regex>
+#include <string_view>
 
+#include "boost/asio/redirect_error.hpp"
 #include "boost/asio/steady_timer.hpp"
 #include "boost/asio/use_awaitable.hpp"
 #include "nlohmann/json.hpp"
@@ -11,6 +13,8 @@ module;
 
 module exchange;
 
+import telemetry;
+
 namespace exchange {
 void from_json(const nlohmann::json& j, OrderBookSnapshot& obs) {
   j.at("lastUpdateId").get_to(obs.last_update_id);
@@ -18,8 +22,20 @@ void from_json(const nlohmann::json& j, OrderBookSnapshot& obs) {
   obs.asks = j.at("asks").get<decltype(OrderBookSnapshot::asks)>();
 }
 
-WebSocketAPI::WebSocketAPI(boost::asio::io_context& io_context)
-    : WebSocket(io_context, "ws-api.binance.com", "443", "/ws-api/v3") {}
+WebSocketAPI::WebSocketAPI(boost::asio::io_context& io_context,
+                           Endpoint endpoint)
+    : WebSocket(io_context, std::move(endpoint)),
+      depth_rtt_metric_(telemetry::metrics().histogram(
+          "ws_api_request_seconds", "WS-API request round-trip time",
+          R"(method="depth")")),
+      time_rtt_metric_(telemetry::metrics().histogram(
+          "ws_api_request_seconds", "WS-API request round-trip time",
+          R"(method="time")")) {
+  pending_.reserve(kMaxInFlight);
+  for (size_t i = 0; i < kMaxInFlight; ++i) {
+    pending_.emplace_back(io_context.get_executor());
+  }
+}
 
 [[nodiscard]] asio::awaitable<OrderBookSnapshot>
 WebSocketAPI::get_orderbook_snapshot(const std::string& market) {
@@ -36,58 +52,113 @@ WebSocketAPI::get_orderbook_snapshot(const std::string& market) {
       market | v::transform([](const char c) { return std::toupper(c); }) |
       r::to<std::string>();
 
-  co_await wait_for_connection();
-  const int id = next_request_id_.fetch_add(1, std::memory_order_relaxed);
-
-  // Set up a promise/future to wait for the subscription confirmation.
-  auto prom = std::make_shared<std::promise<nlohmann::json>>();
-  auto fut = prom->get_future();
-  {
-    std::unique_lock lock(request_handlers_mutex_);
-    request_handlers_[id] = [prom](const nlohmann::json& response) {
-      prom->set_value(response);
-    };
-  }
-
-  const std::string json = R"({"method": "depth", "params": {"symbol":")" +
-                           uppercaseMarket + R"(","limit":5000}, "id": )" +
-                           std::to_string(id) + "}";
+  const int id = next_request_id();
+  const std::string request =
+      R"({"method": "depth", "params": {"symbol":")" + uppercaseMarket +
+      R"(","limit":5000}, "id": )" + std::to_string(id) + "}";
   spdlog::debug("requesting order book snapshot for '{}' (id={})",
                 uppercaseMarket, id);
-  co_await send_json(json);
-
-  const auto executor = co_await asio::this_coro::executor;
-  // Poll until the future is ready.
-  while (fut.wait_for(std::chrono::milliseconds(0)) !=
-         std::future_status::ready) {
-    asio::steady_timer timer(executor, std::chrono::milliseconds(10));
-    co_await timer.async_wait(asio::use_awaitable);
-  }
-
-  {
-    // Ensure the request handler is removed regardless of the outcome.
-    std::unique_lock lock(request_handlers_mutex_);
-    request_handlers_.erase(id);
-  }
+  const ApiResponse response = co_await call(id, request, kRequestTimeout);
+  depth_rtt_metric_.record(response.rtt_ns);
 
   // Parse the response.
-  nlohmann::json response = fut.get();
-  if (!response.contains("result") || response["result"].is_null()) {
+  const nlohmann::json& body = response.body;
+  if (!body.contains("result") || body.at("result").is_null()) {
     spdlog::error("failed to fetch order book snapshot for '{}': {}",
-                  uppercaseMarket, response.dump());
+                  uppercaseMarket, body.dump());
     throw std::runtime_error("failed to fetch order book snapshot");
   }
-  nlohmann::json& result = response["result"];
-  auto snapshot = result.get<OrderBookSnapshot>();
+  auto snapshot = body.at("result").get<OrderBookSnapshot>();
   spdlog::debug("fetched order book snapshot for '{}' (id={})", uppercaseMarket,
                 id);
   co_return snapshot;
 }
 
+asio::awaitable<ServerTime> WebSocketAPI::get_server_time() {
+  const int id = next_request_id();
+  const std::string request =
+      R"({"method": "time", "id": )" + std::to_string(id) + "}";
+  const ApiResponse response = co_await call(id, request, kRequestTimeout);
+  time_rtt_metric_.record(response.rtt_ns);
+
+  const nlohmann::json& body = response.body;
+  if (!body.contains("result") || !body.at("result").contains("serverTime")) {
+    spdlog::error("failed to fetch server time: {}", body.dump());
+    throw std::runtime_error("failed to fetch server time");
+  }
+  co_return ServerTime{
+      .server_ms = body.at("result").at("serverTime").get<int64_t>(),
+      .sent_ns = response.sent_ns,
+      .received_ns = response.received_ns,
+  };
+}
+
+asio::awaitable<ApiResponse> WebSocketAPI::call(
+    const int id, const std::string_view request,
+    const std::chrono::milliseconds timeout) {
+  co_await wait_for_connection();
+
+  Pending& pending = slot(id);
+  {
+    std::unique_lock lock(pending_mutex_);
+    if (pending.id != 0) {
+      throw std::runtime_error("too many WS-API requests in flight");
+    }
+    pending.id = id;
+    pending.response.reset();
+    pending.lost = false;
+    pending.signal.expires_after(timeout);
+  }
+
+  const auto release = [this, &pending] {
+    std::unique_lock lock(pending_mutex_);
+    pending.id = 0;
+  };
+  const int64_t sent_ns = telemetry::now_ns();
+  const int64_t sent_monotonic_ns = telemetry::monotonic_ns();
+  try {
+    co_await send_json(request);
+  } catch (...) {
+    release();
+    throw;
+  }
+  if (!pending.response && !pending.lost) {
+    boost::system::error_code ec;
+    co_await pending.signal.async_wait(
+        asio::redirect_error(asio::use_awaitable, ec));
+  }
+  // Take the result out before the slot can be reused.
+  std::optional<nlohmann::json> response = std::move(pending.response);
+  const int64_t received_ns = pending.received_ns;
+  const bool lost = pending.lost;
+  release();
+  if (!response) {
+    throw std::runtime_error((lost ? "connection lost awaiting request "
+                                   : "no response to request ") +
+                             std::to_string(id));
+  }
+  // The receive time on the wall clock is derived from the round trip, so a
+  // clock step during the request cannot distort either.
+  const int64_t rtt_ns = received_ns - sent_monotonic_ns;
+  co_return ApiResponse{.body = std::move(*response),
+                        .sent_ns = sent_ns,
+                        .received_ns = sent_ns + rtt_ns,
+                        .rtt_ns = rtt_ns};
+}
+
+void WebSocketAPI::on_disconnect() {
+  std::unique_lock lock(pending_mutex_);
+  for (Pending& pending : pending_) {
+    if (pending.id == 0 || pending.response) continue;
+    pending.lost = true;
+    pending.signal.cancel();
+  }
+}
+
 asio::awaitable<void> WebSocketAPI::process_message(
-    const std::string& message) {
+    const std::string_view message) {
   try {
-    const auto j = nlohmann::json::parse(message);
+    auto j = nlohmann::json::parse(message);
 
     // Then process request events if present.
     if (!j.contains("id")) {
@@ -96,15 +167,14 @@ asio::awaitable<void> WebSocketAPI::process_message(
     }
 
     const int id = j["id"].get<int>();
-    // Taking a unique (write) lock here since we modify the map.
-    std::unique_lock lock(request_handlers_mutex_);
-    if (const auto it = request_handlers_.find(id);
-        it != request_handlers_.end()) {
-      // Retrieve and remove the handler.
-      const auto handler = std::move(it->second);
-      request_handlers_.erase(it);
-      lock.unlock();
-      handler(j);
+    // Taking a unique (write) lock here since we modify the slot.
+    std::unique_lock lock(pending_mutex_);
+    if (Pending& pending = slot(id);
+        id != 0 && pending.id == id && !pending.response && !pending.lost) {
+      // Hand the response over and wake the caller.
+      pending.received_ns = telemetry::monotonic_ns();
+      pending.response = std::move(j);
+      pending.signal.cancel();
       co_return;
     }
 
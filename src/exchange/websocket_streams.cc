@@ -1,7 +1,10 @@
 module;
 #include <chrono>
 #include <future>
+#include <memory>
+#include <ranges>
 #include <shared_mutex>
+#include <string_view>
 
 #include "boost/asio/steady_timer.hpp"
 #include "boost/asio/use_awaitable.hpp"
@@ -10,28 +13,44 @@ module;
 
 module exchange;
 
+import sbe;
+import telemetry;
+
 namespace exchange {
 namespace asio = boost::asio;
 
-WebSocketStreams::WebSocketStreams(asio::io_context& ioc)
-    : WebSocket(ioc, "stream.binance.com", "9443", "/stream") {}
+namespace {
+// Per-message log statements (see telemetry::log).
+const telemetry::LogSite kNoHandler(telemetry::LogLevel::kError,
+                                    "no handler registered for stream: {}");
+const telemetry::LogSite kUnknownMessage(telemetry::LogLevel::kDebug,
+                                         "unknown WS Streams message: {}");
+const telemetry::LogSite kParseError(telemetry::LogLevel::kError,
+                                     "error parsing message: {}");
+const telemetry::LogSite kUndecodableFrame(
+    telemetry::LogLevel::kError, "undecodable SBE frame ({} bytes)");
+}  // namespace
+
+WebSocketStreams::WebSocketStreams(asio::io_context& ioc, Endpoint endpoint)
+    : WebSocket(ioc, std::move(endpoint)),
+      unknown_stream_metric_(telemetry::metrics().counter(
+          "ws_unknown_stream_messages_total",
+          "Stream messages without a registered handler")),
+      parse_errors_metric_(telemetry::metrics().counter(
+          "parse_errors_total", "Messages that failed to parse",
+          R"(source="streams")")) {}
 
 /// Subscribe to a stream:
 /// - Registers the handler (under a write lock).
 /// - Sends the SUBSCRIBE command.
 asio::awaitable<void> WebSocketStreams::subscribe(
     const std::string& market, std::unique_ptr<IStreamHandler> handler) {
-  const std::string stream = market + "@" + handler->stream_name();
+  // All-market streams (e.g. `!miniTicker@arr`) have no market prefix.
+  const std::string stream = market.empty()
+                                 ? handler->stream_name()
+                                 : market + "@" + handler->stream_name();
 
-  {
-    // Write-lock the handlers map to register the new handler.
-    std::unique_lock lock(stream_handlers_mutex_);
-    if (stream_handlers_.contains(stream)) {
-      spdlog::error("stream {} is already subscribed", stream);
-      co_return;
-    }
-    stream_handlers_.emplace(stream, std::move(handler));
-  }
+  if (!register_handler(stream, std::move(handler))) co_return;
 
   co_await wait_for_connection();
   const int id = next_request_id_.fetch_add(1, std::memory_order_relaxed);
@@ -76,6 +95,28 @@ asio::awaitable<void> WebSocketStreams::subscribe(
   co_return;
 }
 
+bool WebSocketStreams::register_handler(
+    const std::string& stream, std::unique_ptr<IStreamHandler> handler) {
+  // Write-lock the handlers map to register the new handler.
+  std::unique_lock lock(stream_handlers_mutex_);
+  if (stream_handlers_.contains(stream)) {
+    spdlog::error("stream {} is already subscribed", stream);
+    return false;
+  }
+  const std::string labels = R"(stream=")" + stream + R"(")";
+  stream_handlers_.emplace(
+      stream,
+      StreamEntry{
+          .handler = std::move(handler),
+          .messages = telemetry::metrics().counter(
+              "stream_messages_total", "Messages received per stream", labels),
+          .bytes = telemetry::metrics().counter(
+              "stream_bytes_total", "Message bytes received per stream",
+              labels),
+      });
+  return true;
+}
+
 /// Unsubscribe from a stream:
 /// - Removes the handler (under a write lock).
 /// - Sends the UNSUBSCRIBE command.
@@ -173,10 +214,29 @@ WebSocketStreams::list_subscriptions() {
   co_return subscriptions;
 }
 
+/// A new connection starts without subscriptions: restore the registered ones.
+/// The response is not awaited; a failure shows up as a silent stream.
+asio::awaitable<void> WebSocketStreams::on_reconnect() {
+  nlohmann::json params = nlohmann::json::array();
+  {
+    std::shared_lock lock(stream_handlers_mutex_);
+    for (const auto& stream : stream_handlers_ | std::views::keys) {
+      params.push_back(stream);
+    }
+  }
+  if (params.empty()) co_return;
+
+  const int id = next_request_id_.fetch_add(1, std::memory_order_relaxed);
+  const nlohmann::json request = {
+      {"method", "SUBSCRIBE"}, {"params", params}, {"id", id}};
+  spdlog::info("resubscribing to {} streams (id={})", params.size(), id);
+  co_await send_json(request.dump());
+}
+
 /// Process an incoming message by first checking for stream events (hot path)
 /// and then for request events.
 asio::awaitable<void> WebSocketStreams::process_message(
-    const std::string& message) {
+    const std::string_view message) {
   try {
     auto j = nlohmann::json::parse(message);
 
@@ -185,14 +245,24 @@ asio::awaitable<void> WebSocketStreams::process_message(
       const std::string streamName = j["stream"].get<std::string>();
       const auto& data = j["data"];
 
-      // Use a shared (read) lock on the handlers map.
-      std::shared_lock lock(stream_handlers_mutex_);
-      if (const auto it = stream_handlers_.find(streamName);
-          it != stream_handlers_.end()) {
-        co_await it->second->handle(data);
+      // Copy the handler out under a shared (read) lock: it must not be held
+      // across co_await, or register_handler on this thread deadlocks.
+      std::shared_ptr<IStreamHandler> handler;
+      {
+        std::shared_lock lock(stream_handlers_mutex_);
+        if (const auto it = stream_handlers_.find(streamName);
+            it != stream_handlers_.end()) {
+          it->second.messages.add();
+          it->second.bytes.add(message.size());
+          handler = it->second.handler;
+        }
+      }
+      if (handler) {
+        co_await handler->handle(data);
         co_return;
       }
-      spdlog::error("no handler registered for stream: {}", streamName);
+      unknown_stream_metric_.add();
+      telemetry::log(kNoHandler, streamName);
     }
 
     // Then process request events if present.
@@ -211,9 +281,39 @@ asio::awaitable<void> WebSocketStreams::process_message(
       }
     }
 
-    spdlog::debug("unknown WS Streams message: {}", j.dump());
+    if (telemetry::log_enabled(telemetry::LogLevel::kDebug)) {
+      telemetry::log(kUnknownMessage, j.dump());
+    }
   } catch (const std::exception& ex) {
-    spdlog::error("error parsing message: {}", ex.what());
+    parse_errors_metric_.add();
+    telemetry::log(kParseError, ex.what());
+  }
+}
+
+/// SBE frames carry no stream name: it is derived from the template and the
+/// symbol in the frame, into a reused buffer.
+asio::awaitable<void> WebSocketStreams::process_binary(
+    const std::string_view frame) {
+  if (!sbe::stream_name(frame, sbe_stream_)) {
+    parse_errors_metric_.add();
+    telemetry::log(kUndecodableFrame, frame.size());
+    co_return;
+  }
+  std::shared_ptr<IStreamHandler> handler;
+  {
+    std::shared_lock lock(stream_handlers_mutex_);
+    if (const auto it = stream_handlers_.find(sbe_stream_);
+        it != stream_handlers_.end()) {
+      it->second.messages.add();
+      it->second.bytes.add(frame.size());
+      handler = it->second.handler;
+    }
+  }
+  if (handler) {
+    co_await handler->handle_sbe(frame);
+    co_return;
   }
+  unknown_stream_metric_.add();
+  telemetry::log(kNoHandler, sbe_stream_);
 }
 }  // namespace exchange
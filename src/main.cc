@@ -1,11 +1,28 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <format>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include "boost/asio/awaitable.hpp"
 #include "boost/asio/co_spawn.hpp"
 #include "boost/asio/detached.hpp"
 #include "boost/asio/io_context.hpp"
+#include "boost/asio/post.hpp"
+#include "boost/asio/steady_timer.hpp"
+#include "boost/asio/use_awaitable.hpp"
 #include "ftxui/component/component.hpp"
 #include "ftxui/component/screen_interactive.hpp"
 #include "rpp/subjects/publish_subject.hpp"
@@ -13,43 +30,398 @@
 #include "spdlog/spdlog.h"
 
 import exchange;
+import shm;
 import state;
+import telemetry;
+import ui;
 import ui.component;
 import ui.widget;
 
 using namespace std::chrono_literals;
 using namespace ftxui;
 
-int main() {
+namespace {
+// Top of `book` and its best bid/offer into the shared-memory region.
+void PublishBook(shm::Publisher& publisher, const state::OrderBook& book) {
+  std::array<shm::Level, shm::kBookDepth> bids{};
+  std::array<shm::Level, shm::kBookDepth> asks{};
+  const auto copy_top = [](const auto& side, auto& out) {
+    size_t count = 0;
+    for (const auto& [price, entry] : side) {
+      if (count == out.size()) break;
+      out[count++] = shm::Level{entry.price, entry.quantity};
+    }
+    return count;
+  };
+  const size_t bid_count = copy_top(book.bids | std::views::reverse, bids);
+  const size_t ask_count = copy_top(book.asks, asks);
+  const auto event_ns = static_cast<int64_t>(book.timestamp) * 1'000'000;
+  publisher.publish_book(book.symbol, event_ns, book.last_update_id,
+                         std::span(bids).first(bid_count),
+                         std::span(asks).first(ask_count));
+  if (bid_count != 0 && ask_count != 0) {
+    publisher.publish_bbo(book.symbol, event_ns, book.last_update_id, bids[0],
+                          asks[0]);
+  }
+}
+
+void PublishTrade(shm::Publisher& publisher, const state::Trade& trade) {
+  const auto ns = [](const std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               time.time_since_epoch())
+        .count();
+  };
+  publisher.publish_trade(shm::Trade{
+      .symbol = shm::make_symbol(trade.symbol),
+      .event_ns = ns(trade.event_time),
+      .trade_ns = ns(trade.trade_time),
+      .trade_id = trade.trade_id,
+      .price = trade.price,
+      .quantity = trade.quantity,
+      .is_buyer_market_maker = trade.is_buyer_market_maker,
+  });
+}
+}  // namespace
+
+int main(const int argc, char* argv[]) {
+  const std::vector<std::string_view> args(argv + 1, argv + argc);
+  // Write only changed cells; cuts output bytes on slow (e.g. SSH) links.
+  const bool diff_output = std::ranges::contains(args, "--diff-output");
+  // Value of a `--name=value` flag, if given.
+  const auto flag_value =
+      [&args](const std::string_view name) -> std::optional<std::string_view> {
+    for (const auto arg : args) {
+      if (arg.starts_with(name) && arg.substr(name.size()).starts_with("="))
+        return arg.substr(name.size() + 1);
+    }
+    return std::nullopt;
+  };
+  // Endpoint overrides, e.g. `--streams=wss://localhost:9443/stream` to run
+  // against tools/mock_server, whose self-signed certificate also needs
+  // `--insecure` (no certificate or host name checks).
+  if (std::ranges::contains(args, "--insecure")) {
+    exchange::set_tls_verification(false);
+  }
+  const auto endpoint_flag = [&flag_value](const std::string_view name,
+                                           const exchange::Endpoint& fallback) {
+    const auto url = flag_value(name);
+    if (!url) return fallback;
+    if (auto endpoint = exchange::parse_endpoint(*url)) return *endpoint;
+    std::cerr << "invalid endpoint: " << *url << '\n';
+    return fallback;
+  };
+  const auto streams_endpoint =
+      endpoint_flag("--streams", exchange::kBinanceStreams);
+  const auto api_endpoint = endpoint_flag("--api", exchange::kBinanceApi);
+  // SBE market data per stream, e.g. `--sbe=trade,depth`: those streams are
+  // received as binary frames from `--sbe-streams` (kBinanceSbeStreams by
+  // default), which requires the API key in BINANCE_API_KEY.
+  const auto sbe_flag = flag_value("--sbe").value_or("");
+  const auto encoding_of = [&sbe_flag](const std::string_view stream) {
+    return std::ranges::contains(sbe_flag | std::views::split(','), stream,
+                                 [](const auto part) {
+                                   return std::string_view(part);
+                                 })
+               ? exchange::Encoding::kSbe
+               : exchange::Encoding::kJson;
+  };
+  const auto trade_encoding = encoding_of("trade");
+  const auto depth_encoding = encoding_of("depth");
+  const auto sbe_endpoint =
+      endpoint_flag("--sbe-streams", exchange::kBinanceSbeStreams);
+  // Redundant market data, `--redundant`: every stream is also received over
+  // a second connection, to another resolved address of the same host or to
+  // `--redundant-streams=URL`, and each event is taken from whichever
+  // connection delivers it first (see exchange::FeedArbiter).
+  const bool redundant = std::ranges::contains(args, "--redundant") ||
+                         flag_value("--redundant-streams").has_value();
+  const auto redundant_endpoint =
+      endpoint_flag("--redundant-streams", streams_endpoint);
+  // permessage-deflate per link, e.g. `--deflate=streams,api` (`sbe` for the
+  // SBE link). `--deflate-window-bits=N` (9..15) bounds both compression
+  // windows; `--deflate-no-context-takeover` compresses every message on its
+  // own, trading ratio for memory. Compare ws_compression_ratio_percent with
+  // ws_read_cpu_seconds to see which links it pays off on.
+  const auto deflate_flag = flag_value("--deflate").value_or("");
+  const auto deflate_for = [&](const std::string_view link) {
+    exchange::DeflateOptions options;
+    options.enabled = std::ranges::contains(
+        deflate_flag | std::views::split(','), link,
+        [](const auto part) { return std::string_view(part); });
+    if (const auto bits = flag_value("--deflate-window-bits")) {
+      int window_bits = 15;
+      std::from_chars(bits->data(), bits->data() + bits->size(), window_bits);
+      window_bits = std::clamp(window_bits, 9, 15);
+      options.server_max_window_bits = window_bits;
+      options.client_max_window_bits = window_bits;
+    }
+    const bool no_context_takeover =
+        std::ranges::contains(args, "--deflate-no-context-takeover");
+    options.server_no_context_takeover = no_context_takeover;
+    options.client_no_context_takeover = no_context_takeover;
+    return options;
+  };
+  // Raw frame capture for tools/replay, e.g. `--journal=logs/feed.journal`.
+  std::unique_ptr<exchange::Journal> journal;
+  if (const auto path = flag_value("--journal")) {
+    journal = std::make_unique<exchange::Journal>(std::string(*path));
+  }
+  // Chrome/Perfetto trace of recent messages and frames, written on exit.
+  const auto trace_path = flag_value("--trace");
+  // Share books and trades with other processes on this host through POSIX
+  // shared memory (see shm::Reader), e.g. `--shm=/binance-terminal`.
+  std::unique_ptr<shm::Publisher> shm_publisher;
+  if (const auto name = flag_value("--shm")) {
+    try {
+      shm_publisher = std::make_unique<shm::Publisher>(std::string(*name));
+    } catch (const std::exception& e) {
+      std::cerr << "cannot create shared memory region: " << e.what() << '\n';
+    }
+  }
+  // Prometheus scrape endpoint, e.g. `--metrics-port=9100`.
+  unsigned short metrics_port = 0;
+  if (const auto port = flag_value("--metrics-port")) {
+    std::from_chars(port->data(), port->data() + port->size(), metrics_port);
+  }
+  // Low-latency io: `--busy-poll=spin|pause|backoff` polls the io context
+  // instead of sleeping in epoll; `--io-cpu=N`, `--ui-cpu=N` and
+  // `--worker-cpu=N` (binary log writer) pin threads to cores.
+  std::optional<exchange::IdlePolicy> busy_poll;
+  if (const auto policy = flag_value("--busy-poll")) {
+    if (*policy == "spin") {
+      busy_poll = exchange::IdlePolicy::kSpin;
+    } else if (*policy == "pause") {
+      busy_poll = exchange::IdlePolicy::kPause;
+    } else if (*policy == "backoff") {
+      busy_poll = exchange::IdlePolicy::kBackoff;
+    } else {
+      std::cerr << "invalid --busy-poll policy: " << *policy << '\n';
+    }
+  }
+  const auto cpu_flag = [&flag_value](const std::string_view name) {
+    int cpu = -1;
+    if (const auto value = flag_value(name)) {
+      std::from_chars(value->data(), value->data() + value->size(), cpu);
+    }
+    return cpu;
+  };
+  const int io_cpu = cpu_flag("--io-cpu");
+  const int ui_cpu = cpu_flag("--ui-cpu");
+  const int worker_cpu = cpu_flag("--worker-cpu");
+  // Keyboard order entry over the WS API, enabled by `--order-qty=0.001`:
+  // 'b' bids at the best bid, 'a' offers at the best ask and 'c' cancels the
+  // last order. Needs BINANCE_API_KEY and either BINANCE_ED25519_KEY (PEM
+  // file) or BINANCE_API_SECRET (HMAC). `--price-decimals=N` and
+  // `--qty-decimals=N` follow the symbol's tick and lot sizes.
+  double order_qty = 0;
+  if (const auto qty = flag_value("--order-qty")) {
+    std::from_chars(qty->data(), qty->data() + qty->size(), order_qty);
+  }
+  exchange::OrderSpec order_spec{.symbol = "BTCUSDT"};
+  if (const auto value = flag_value("--price-decimals")) {
+    std::from_chars(value->data(), value->data() + value->size(),
+                    order_spec.price_decimals);
+  }
+  if (const auto value = flag_value("--qty-decimals")) {
+    std::from_chars(value->data(), value->data() + value->size(),
+                    order_spec.quantity_decimals);
+  }
+
   auto file_sink = spdlog::basic_logger_mt("logger", "logs/basic-log.txt");
   spdlog::set_default_logger(std::move(file_sink));
+  spdlog::info("io backend: {}", exchange::io_backend());
+  // Hot-path log statements go to a binary file written off the io thread,
+  // rendered with tools/logdump, e.g. `--binary-log=logs/hot.binlog`.
+  if (const auto path = flag_value("--binary-log");
+      path && !telemetry::start_binary_log(std::string(*path),
+                                           {.cpu = worker_cpu})) {
+    std::cerr << "cannot open binary log: " << *path << '\n';
+  }
 
   boost::asio::io_context io_context;
 
   // Instantiate Binance client.
-  exchange::WebSocketStreams ws(io_context);
-  exchange::WebSocketAPI api(io_context);
+  exchange::WebSocketStreams ws(io_context, streams_endpoint);
+  exchange::WebSocketAPI api(io_context, api_endpoint);
+  ws.set_journal(journal.get());
+  api.set_journal(journal.get());
+  ws.set_deflate(deflate_for("streams"));
+  api.set_deflate(deflate_for("api"));
+  std::optional<exchange::WebSocketStreams> sbe_ws;
+  if (trade_encoding == exchange::Encoding::kSbe ||
+      depth_encoding == exchange::Encoding::kSbe) {
+    sbe_ws.emplace(io_context, sbe_endpoint);
+    sbe_ws->set_journal(journal.get());
+    sbe_ws->set_deflate(deflate_for("sbe"));
+    if (const char* api_key = std::getenv("BINANCE_API_KEY")) {
+      sbe_ws->set_api_key(api_key);
+    } else {
+      spdlog::warn("BINANCE_API_KEY is not set; SBE streams will be refused");
+    }
+  }
+  // Second connections for redundant feeds. They are not journaled: replay
+  // has a single connection per link.
+  std::optional<exchange::WebSocketStreams> ws_backup;
+  std::optional<exchange::WebSocketStreams> sbe_ws_backup;
+  std::optional<exchange::FeedArbiter> arbiter;
+  std::optional<exchange::FeedArbiter> sbe_arbiter;
+  if (redundant) {
+    ws_backup.emplace(io_context, redundant_endpoint);
+    ws_backup->set_preferred_address(1);
+    ws_backup->set_deflate(deflate_for("streams"));
+    arbiter.emplace(std::vector<exchange::WebSocketStreams*>{
+        &ws, &*ws_backup});
+    if (sbe_ws) {
+      sbe_ws_backup.emplace(io_context, sbe_endpoint);
+      sbe_ws_backup->set_preferred_address(1);
+      sbe_ws_backup->set_deflate(deflate_for("sbe"));
+      if (const char* api_key = std::getenv("BINANCE_API_KEY")) {
+        sbe_ws_backup->set_api_key(api_key);
+      }
+      sbe_arbiter.emplace(std::vector<exchange::WebSocketStreams*>{
+          &*sbe_ws, &*sbe_ws_backup});
+    }
+  }
+  std::unique_ptr<exchange::RequestSigner> signer;
+  std::optional<exchange::OrderEntry> order_entry;
+  if (order_qty > 0) {
+    try {
+      if (const char* pem = std::getenv("BINANCE_ED25519_KEY")) {
+        signer = std::make_unique<exchange::Ed25519Signer>(pem);
+      } else if (const char* secret = std::getenv("BINANCE_API_SECRET")) {
+        signer = std::make_unique<exchange::HmacSigner>(secret);
+      }
+    } catch (const std::exception& e) {
+      std::cerr << "cannot load signing key: " << e.what() << '\n';
+      return 1;
+    }
+    const char* api_key = std::getenv("BINANCE_API_KEY");
+    if (api_key == nullptr || signer == nullptr) {
+      std::cerr << "order entry needs BINANCE_API_KEY and "
+                   "BINANCE_ED25519_KEY or BINANCE_API_SECRET\n";
+      return 1;
+    }
+    order_entry.emplace(api, order_spec, api_key, *signer);
+  }
   // Start the IO coroutines.
   boost::asio::co_spawn(io_context, ws.run(), boost::asio::detached);
   boost::asio::co_spawn(io_context, api.run(), boost::asio::detached);
+  for (auto* feed : {&sbe_ws, &ws_backup, &sbe_ws_backup}) {
+    if (*feed) {
+      boost::asio::co_spawn(io_context, (*feed)->run(),
+                            boost::asio::detached);
+    }
+  }
+  if (shm_publisher) {
+    // Readers judge liveness by the heartbeat, which must keep moving while
+    // the market is quiet.
+    boost::asio::co_spawn(
+        io_context,
+        [&publisher = *shm_publisher] -> boost::asio::awaitable<void> {
+          boost::asio::steady_timer timer(
+              co_await boost::asio::this_coro::executor);
+          while (true) {
+            publisher.heartbeat();
+            timer.expires_after(shm::Publisher::kHeartbeatInterval);
+            co_await timer.async_wait(boost::asio::use_awaitable);
+          }
+        },
+        boost::asio::detached);
+  }
+  if (metrics_port != 0) {
+    boost::asio::co_spawn(io_context, telemetry::serve_metrics(metrics_port),
+                          boost::asio::detached);
+  }
+  boost::asio::co_spawn(
+      io_context,
+      [] -> boost::asio::awaitable<void> {
+        auto& allocations = telemetry::metrics().gauge(
+            "process_allocations", "Heap allocations since start");
+        const auto executor = co_await boost::asio::this_coro::executor;
+        while (true) {
+          allocations.set(
+              static_cast<int64_t>(telemetry::allocation_count()));
+          boost::asio::steady_timer timer(executor, 1s);
+          co_await timer.async_wait(boost::asio::use_awaitable);
+        }
+      },
+      boost::asio::detached);
+  // Keep the exchange clock offset fresh for latency tracing.
+  boost::asio::co_spawn(
+      io_context,
+      [&api] -> boost::asio::awaitable<void> {
+        const auto executor = co_await boost::asio::this_coro::executor;
+        while (true) {
+          try {
+            const auto time = co_await api.get_server_time();
+            telemetry::tracer().clock().add_sample(
+                time.sent_ns, time.server_ms * 1'000'000, time.received_ns);
+          } catch (const std::exception& e) {
+            spdlog::warn("clock sync failed: {}", e.what());
+          }
+          boost::asio::steady_timer timer(executor, 30s);
+          co_await timer.async_wait(boost::asio::use_awaitable);
+        }
+      },
+      boost::asio::detached);
 
   // Set up stream handlers.
-  auto trade_handler = std::make_unique<state::TradeHandler>();
-  auto order_book_handler = std::make_unique<state::OrderBookHandler>(api);
+  auto trade_handler = std::make_unique<state::TradeHandler>(trade_encoding);
+  auto order_book_handler =
+      std::make_unique<state::OrderBookHandler>(api, depth_encoding);
 
   // WARN: moving the following subject fetching lines below the co_spawn will
   // cause invalid reference error.
   const auto& trade_subject = trade_handler->get_subject();
   const auto& order_book_subject = order_book_handler->get_subject();
+  const auto& delta_subject = order_book_handler->get_delta_subject();
+  const state::OrderBookHandler& order_book_state = *order_book_handler;
+
+  // Published from the io thread, which emits both subjects.
+  if (shm_publisher) {
+    trade_subject.get_observable().subscribe(
+        [&publisher = *shm_publisher](const state::Trade& trade) {
+          PublishTrade(publisher, trade);
+        });
+    order_book_subject.get_observable().subscribe(
+        [&publisher = *shm_publisher](const state::OrderBook& book) {
+          PublishBook(publisher, book);
+        });
+  }
+
+  // Top of book for order entry, from the bookTicker stream: order keys read
+  // the seqlocked quote instead of the depth maps.
+  std::unique_ptr<state::BookTickerHandler> book_ticker_handler;
+  const state::TopOfBook* top_of_book = nullptr;
+  if (order_entry) {
+    book_ticker_handler =
+        std::make_unique<state::BookTickerHandler>(depth_encoding);
+    top_of_book = &book_ticker_handler->top_of_book();
+  }
 
   // Subscribe to the market data stream.
   boost::asio::co_spawn(
       io_context,
-      [&ws, &trade_handler,
-       &order_book_handler] -> boost::asio::awaitable<void> {
+      [&ws, &sbe_ws, &arbiter, &sbe_arbiter, trade_encoding, depth_encoding,
+       &trade_handler, &order_book_handler,
+       &book_ticker_handler] -> boost::asio::awaitable<void> {
         constexpr auto market = "btcusdt";
-        co_await ws.subscribe(market, std::move(trade_handler));
-        co_await ws.subscribe(market, std::move(order_book_handler));
+        const auto subscribe =
+            [&](const exchange::Encoding encoding,
+                std::unique_ptr<exchange::IStreamHandler> handler)
+            -> boost::asio::awaitable<void> {
+          const bool sbe = encoding == exchange::Encoding::kSbe;
+          if (auto& feeds = sbe ? sbe_arbiter : arbiter) {
+            co_await feeds->subscribe(market, std::move(handler));
+          } else {
+            co_await (sbe ? *sbe_ws : ws).subscribe(market, std::move(handler));
+          }
+        };
+        co_await subscribe(trade_encoding, std::move(trade_handler));
+        co_await subscribe(depth_encoding, std::move(order_book_handler));
+        if (book_ticker_handler) {
+          co_await subscribe(depth_encoding, std::move(book_ticker_handler));
+        }
         co_return;
       },
       boost::asio::detached);
@@ -59,20 +431,114 @@ int main() {
   rpp::subjects::publish_subject<component::RedrawSignal> redraw_subject;
   const auto market_trades =
       widget::MarketTrades(trade_subject, header_subject, redraw_subject);
+  const auto candles = widget::Candles(trade_subject, redraw_subject);
+  // Charts stay rendered: a hidden one would not drain its bus.
+  const auto depth_chart = widget::DepthChart(
+      delta_subject,
+      [&io_context, &order_book_state] {
+        boost::asio::post(io_context, [&order_book_state] {
+          order_book_state.publish_reset();
+        });
+      },
+      redraw_subject);
+  const auto heatmap = widget::Heatmap(order_book_subject, redraw_subject);
+  bool show_stats = false;  // toggled with 's'
+  const auto panels = Container::Horizontal(
+      {market_trades, Container::Vertical({candles, depth_chart, heatmap}),
+       Maybe(widget::Stats(), &show_stats)});
+  auto& frame_render = telemetry::metrics().histogram(
+      "frame_render_seconds", "Time to render the whole UI");
+  auto screen = ScreenInteractive::TerminalOutput();
+  ui::DiffScreen diff_screen;
+  // Coalesce redraw bursts (one per trade) into at most 60 frames per second.
+  component::RenderScheduler render_scheduler(
+      component::FrameInterval(60), [&screen, &diff_screen, diff_output] {
+        if (diff_output) {
+          diff_screen.PostEvent(Event::Custom);
+        } else {
+          screen.PostEvent(Event::Custom);
+        }
+      });
+  // DiffScreen reports presented frames itself; ScreenInteractive has no hook
+  // after its write, so count the end of rendering instead.
+  const auto layout = Renderer(
+      panels, [&panels, &frame_render, &render_scheduler, diff_output] {
+        // Components that did not request a redraw reuse their last output.
+        component::BeginFrame(render_scheduler.TakeDirty());
+        const int64_t start = telemetry::monotonic_ns();
+        auto element = panels->Render();
+        frame_render.record(telemetry::monotonic_ns() - start);
+        if (!diff_output) telemetry::tracer().frame_presented();
+        return element;
+      });
 
   // Set up event handlers.
-  auto screen = ScreenInteractive::TerminalOutput();
   header_subject.get_observer().on_next(
       {"Price (USDT)", "Amount (BTC)", "Time"});
   redraw_subject.get_observable().subscribe(
-      [&screen](component::RedrawSignal) { screen.PostEvent(Event::Custom); });
-  const auto shutdown_handler = [&screen, &io_context] {
+      [&render_scheduler](const component::RedrawSignal signal) {
+        render_scheduler.Request(signal.dirty);
+      });
+  const auto shutdown_handler = [&screen, &diff_screen, &io_context] {
     screen.Exit();
+    diff_screen.Exit();
     io_context.stop();
   };
-  const auto ui_handler =
-      CatchEvent(market_trades, [&shutdown_handler](const Event& event) {
+  // Order keys post to the io thread, which owns the order entry.
+  std::string last_order;
+  int orders_sent = 0;
+  const auto order_prefix = std::format(
+      "term{}-", std::chrono::system_clock::now().time_since_epoch() / 1s);
+  const auto order_key = [&](const char key) {
+    boost::asio::co_spawn(
+        io_context,
+        [&, key] -> boost::asio::awaitable<void> {
+          const auto report = [](const std::string_view action,
+                                 const std::string_view id,
+                                 const exchange::OrderAck& ack) {
+            if (ack.accepted()) {
+              spdlog::info("{} {}: acked in {} us, order id {}", action, id,
+                           ack.latency_ns / 1000, ack.order_id);
+            } else {
+              spdlog::warn("{} {} failed: status {}, {}", action, id,
+                           ack.status, ack.error);
+            }
+          };
+          if (key == 'c') {
+            if (last_order.empty()) co_return;
+            const std::string id = std::exchange(last_order, {});
+            report("cancel", id, co_await order_entry->cancel(id));
+            co_return;
+          }
+          if (top_of_book->version() == 0) co_return;  // no quote yet
+          const bool buy = key == 'b';
+          const state::BestBidOffer quote = top_of_book->load();
+          const double price = buy ? quote.bid_price : quote.ask_price;
+          if (price == 0) co_return;
+          const std::string id = order_prefix + std::to_string(++orders_sent);
+          last_order = id;
+          report(buy ? "buy" : "sell", id,
+                 co_await order_entry->place(
+                     buy ? exchange::Side::kBuy : exchange::Side::kSell,
+                     price, order_qty, id));
+        },
+        boost::asio::detached);
+  };
+  const auto ui_handler = CatchEvent(
+      layout,
+      [&shutdown_handler, &show_stats, &order_entry,
+       &order_key](const Event& event) {
         if (event == Event::Custom) return true;
+        if (event == Event::Character('s')) {
+          show_stats = !show_stats;
+          return true;
+        }
+        if (order_entry && (event == Event::Character('b') ||
+                            event == Event::Character('a') ||
+                            event == Event::Character('c'))) {
+          order_key(event.character()[0]);
+          return true;
+        }
         if (event == Event::Escape) {
           shutdown_handler();
           return true;
@@ -81,11 +547,28 @@ int main() {
       });
 
   // Run IO & UI loops.
-  std::thread io_thread([&io_context] { io_context.run(); });
-  screen.Loop(ui_handler);  // run the UI loop in the main thread.
+  std::thread io_thread([&io_context, busy_poll, io_cpu] {
+    if (io_cpu >= 0) telemetry::pin_current_thread(io_cpu);
+    if (busy_poll) {
+      exchange::run_polling(io_context, *busy_poll);
+    } else {
+      io_context.run();
+    }
+  });
+  // Run the UI loop in the main thread.
+  if (ui_cpu >= 0) telemetry::pin_current_thread(ui_cpu);
+  if (diff_output) {
+    diff_screen.Loop(ui_handler);
+  } else {
+    screen.Loop(ui_handler);
+  }
 
   // Clean up.
   shutdown_handler();  // in case user hits Ctrl+C instead of ESC.
   io_thread.join();
+  telemetry::stop_binary_log();
+  if (trace_path) {
+    telemetry::tracer().export_chrome_trace(std::string(*trace_path));
+  }
   return 0;
 }
@@ -0,0 +1,228 @@
+module;
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+module sbe;
+
+namespace sbe {
+namespace {
+// Powers of ten that are exact doubles.
+constexpr auto kPowersOfTen = [] {
+  std::array<double, 23> powers{};
+  double power = 1.0;
+  for (double& p : powers) {
+    p = power;
+    power *= 10.0;
+  }
+  return powers;
+}();
+
+// The root block of a `template_id` frame, leaving `position` after it. Null
+// if the frame is not one.
+const char* RootBlock(const std::string_view frame,
+                      const TemplateId template_id,
+                      const uint16_t min_block_length, size_t& position) {
+  if (frame.size() < MessageHeader::kSize) return nullptr;
+  const MessageHeader header(frame.data());
+  if (header.schema_id() != kSchemaId ||
+      header.template_id() != template_id ||
+      header.block_length() < min_block_length ||
+      frame.size() - MessageHeader::kSize < header.block_length()) {
+    return nullptr;
+  }
+  position = MessageHeader::kSize + header.block_length();
+  return frame.data() + MessageHeader::kSize;
+}
+
+// A repeating group at `position`. `Count` is the width of its entry count:
+// uint32 for groupSizeEncoding, uint16 for groupSize16Encoding.
+template <typename Count, typename Entry>
+bool ReadGroup(const std::string_view frame, size_t& position,
+               Group<Entry>& out) {
+  constexpr size_t kDimensionSize = sizeof(uint16_t) + sizeof(Count);
+  if (frame.size() - position < kDimensionSize) return false;
+  const auto block_length = load<uint16_t>(frame.data() + position);
+  const auto count = load<Count>(frame.data() + position + sizeof(uint16_t));
+  position += kDimensionSize;
+  if (block_length < Entry::kMinBlockLength ||
+      (frame.size() - position) / block_length < count) {
+    return false;
+  }
+  out = Group<Entry>(frame.data() + position, block_length, count);
+  position += size_t{count} * block_length;
+  return true;
+}
+
+// varString8: a one-byte length followed by the characters.
+bool ReadSymbol(const std::string_view frame, size_t& position,
+                std::string_view& out) {
+  if (frame.size() - position < 1) return false;
+  const auto length = static_cast<uint8_t>(frame[position]);
+  ++position;
+  if (frame.size() - position < length) return false;
+  out = frame.substr(position, length);
+  position += length;
+  return true;
+}
+
+// Symbol of a DepthSnapshotStreamEvent, which has no flyweight: the terminal
+// keeps its books from diffs.
+std::optional<std::string_view> DepthSnapshotSymbol(
+    const std::string_view frame) {
+  constexpr uint16_t kMinBlockLength = 18;
+  size_t position = 0;
+  Group<LevelEntry> bids;
+  Group<LevelEntry> asks;
+  std::string_view symbol;
+  if (RootBlock(frame, TemplateId::kDepthSnapshot, kMinBlockLength,
+                position) == nullptr ||
+      !ReadGroup<uint16_t>(frame, position, bids) ||
+      !ReadGroup<uint16_t>(frame, position, asks) ||
+      !ReadSymbol(frame, position, symbol)) {
+    return std::nullopt;
+  }
+  return symbol;
+}
+}  // namespace
+
+double decimal(const int64_t mantissa, const int8_t exponent) noexcept {
+  const auto value = static_cast<double>(mantissa);
+  if (exponent >= 0) {
+    return exponent < std::ssize(kPowersOfTen)
+               ? value * kPowersOfTen[exponent]
+               : value * std::pow(10.0, exponent);
+  }
+  return -exponent < std::ssize(kPowersOfTen)
+             ? value / kPowersOfTen[-exponent]
+             : value * std::pow(10.0, exponent);
+}
+
+std::optional<int64_t> mantissa(std::string_view text,
+                                const int8_t exponent) noexcept {
+  if (exponent > 0) return std::nullopt;
+  const bool negative = text.starts_with('-');
+  if (negative) text.remove_prefix(1);
+  const size_t dot = text.find('.');
+  const std::string_view whole = text.substr(0, dot);
+  const std::string_view fraction =
+      dot == std::string_view::npos ? std::string_view() : text.substr(dot + 1);
+  if (whole.empty() && fraction.empty()) return std::nullopt;
+
+  int64_t value = 0;
+  const auto append = [&value](const char c) {
+    if (!std::isdigit(static_cast<unsigned char>(c)) ||
+        value > (std::numeric_limits<int64_t>::max() - 9) / 10) {
+      return false;
+    }
+    value = value * 10 + (c - '0');
+    return true;
+  };
+  for (const char c : whole) {
+    if (!append(c)) return std::nullopt;
+  }
+  const size_t scale = -exponent;
+  for (size_t i = 0; i < scale; ++i) {
+    if (!append(i < fraction.size() ? fraction[i] : '0')) return std::nullopt;
+  }
+  for (size_t i = scale; i < fraction.size(); ++i) {
+    if (!std::isdigit(static_cast<unsigned char>(fraction[i]))) {
+      return std::nullopt;
+    }
+  }
+  return negative ? -value : value;
+}
+
+std::optional<TemplateId> template_of(const std::string_view frame) noexcept {
+  if (frame.size() < MessageHeader::kSize) return std::nullopt;
+  const MessageHeader header(frame.data());
+  if (header.schema_id() != kSchemaId) return std::nullopt;
+  return header.template_id();
+}
+
+bool stream_name(const std::string_view frame, std::string& out) {
+  const auto template_id = template_of(frame);
+  if (!template_id) return false;
+  std::string_view symbol;
+  std::string_view suffix;
+  switch (*template_id) {
+    case TemplateId::kTrades:
+      if (const auto event = TradesEvent::wrap(frame)) {
+        symbol = event->symbol();
+        suffix = "@trade";
+      }
+      break;
+    case TemplateId::kBestBidAsk:
+      if (const auto event = BestBidAskEvent::wrap(frame)) {
+        symbol = event->symbol();
+        suffix = "@bestBidAsk";
+      }
+      break;
+    case TemplateId::kDepthSnapshot:
+      if (const auto snapshot_symbol = DepthSnapshotSymbol(frame)) {
+        symbol = *snapshot_symbol;
+        suffix = "@depth20";
+      }
+      break;
+    case TemplateId::kDepthDiff:
+      if (const auto event = DepthDiffEvent::wrap(frame)) {
+        symbol = event->symbol();
+        suffix = "@depth";
+      }
+      break;
+  }
+  if (suffix.empty()) return false;
+  // Stream names use the lowercase symbol.
+  out.clear();
+  for (const unsigned char c : symbol) {
+    out.push_back(static_cast<char>(std::tolower(c)));
+  }
+  out.append(suffix);
+  return true;
+}
+
+std::optional<TradesEvent> TradesEvent::wrap(
+    const std::string_view frame) noexcept {
+  TradesEvent event;
+  size_t position = 0;
+  event.block_ = RootBlock(frame, kTemplateId, kMinBlockLength, position);
+  if (event.block_ == nullptr ||
+      !ReadGroup<uint32_t>(frame, position, event.trades_) ||
+      !ReadSymbol(frame, position, event.symbol_)) {
+    return std::nullopt;
+  }
+  return event;
+}
+
+std::optional<BestBidAskEvent> BestBidAskEvent::wrap(
+    const std::string_view frame) noexcept {
+  BestBidAskEvent event;
+  size_t position = 0;
+  event.block_ = RootBlock(frame, kTemplateId, kMinBlockLength, position);
+  if (event.block_ == nullptr ||
+      !ReadSymbol(frame, position, event.symbol_)) {
+    return std::nullopt;
+  }
+  return event;
+}
+
+std::optional<DepthDiffEvent> DepthDiffEvent::wrap(
+    const std::string_view frame) noexcept {
+  DepthDiffEvent event;
+  size_t position = 0;
+  event.block_ = RootBlock(frame, kTemplateId, kMinBlockLength, position);
+  if (event.block_ == nullptr ||
+      !ReadGroup<uint16_t>(frame, position, event.bids_) ||
+      !ReadGroup<uint16_t>(frame, position, event.asks_) ||
+      !ReadSymbol(frame, position, event.symbol_)) {
+    return std::nullopt;
+  }
+  return event;
+}
+}  // namespace sbe
@@ -0,0 +1,126 @@
+module;
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+
+module sbe;
+
+namespace sbe {
+namespace {
+// Appends little-endian fields to one frame.
+class Writer {
+ public:
+  Writer(const TemplateId template_id, const uint16_t block_length,
+         const size_t size_hint) {
+    out_.reserve(MessageHeader::kSize + size_hint);
+    put(block_length);
+    put(static_cast<uint16_t>(template_id));
+    put(kSchemaId);
+    put(kSchemaVersion);
+  }
+
+  template <typename T>
+  void put(const T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out_.append(bytes, sizeof(T));
+  }
+
+  template <typename Count>
+  void group(const uint16_t block_length, const size_t count) {
+    put(block_length);
+    put(static_cast<Count>(count));
+  }
+
+  void symbol(const std::string_view symbol) {
+    const size_t length = std::min<size_t>(symbol.size(), UINT8_MAX);
+    put(static_cast<uint8_t>(length));
+    out_.append(symbol.substr(0, length));
+  }
+
+  std::string take() { return std::move(out_); }
+
+ private:
+  std::string out_;
+};
+
+void PutLevels(Writer& writer, const std::span<const LevelFields> levels) {
+  writer.group<uint16_t>(LevelEntry::kMinBlockLength, levels.size());
+  for (const auto& level : levels) {
+    writer.put(level.price);
+    writer.put(level.qty);
+  }
+}
+}  // namespace
+
+std::string encode_trades(const int64_t event_time_us,
+                          const int64_t transact_time_us,
+                          const int8_t price_exponent,
+                          const int8_t qty_exponent,
+                          const std::span<const TradeFields> trades,
+                          const std::string_view symbol) {
+  Writer writer(TemplateId::kTrades, TradesEvent::kMinBlockLength,
+                TradesEvent::kMinBlockLength + 6 +
+                    trades.size() * TradeEntry::kMinBlockLength + 1 +
+                    symbol.size());
+  writer.put(event_time_us);
+  writer.put(transact_time_us);
+  writer.put(price_exponent);
+  writer.put(qty_exponent);
+  writer.group<uint32_t>(TradeEntry::kMinBlockLength, trades.size());
+  for (const auto& trade : trades) {
+    writer.put(trade.id);
+    writer.put(trade.price);
+    writer.put(trade.qty);
+    writer.put(static_cast<uint8_t>(trade.is_buyer_maker));
+  }
+  writer.symbol(symbol);
+  return writer.take();
+}
+
+std::string encode_best_bid_ask(const int64_t event_time_us,
+                                const int64_t book_update_id,
+                                const int8_t price_exponent,
+                                const int8_t qty_exponent,
+                                const LevelFields bid, const LevelFields ask,
+                                const std::string_view symbol) {
+  Writer writer(TemplateId::kBestBidAsk, BestBidAskEvent::kMinBlockLength,
+                BestBidAskEvent::kMinBlockLength + 1 + symbol.size());
+  writer.put(event_time_us);
+  writer.put(book_update_id);
+  writer.put(price_exponent);
+  writer.put(qty_exponent);
+  writer.put(bid.price);
+  writer.put(bid.qty);
+  writer.put(ask.price);
+  writer.put(ask.qty);
+  writer.symbol(symbol);
+  return writer.take();
+}
+
+std::string encode_depth_diff(const int64_t event_time_us,
+                              const int64_t first_book_update_id,
+                              const int64_t last_book_update_id,
+                              const int8_t price_exponent,
+                              const int8_t qty_exponent,
+                              const std::span<const LevelFields> bids,
+                              const std::span<const LevelFields> asks,
+                              const std::string_view symbol) {
+  Writer writer(TemplateId::kDepthDiff, DepthDiffEvent::kMinBlockLength,
+                DepthDiffEvent::kMinBlockLength + 8 +
+                    (bids.size() + asks.size()) * LevelEntry::kMinBlockLength +
+                    1 + symbol.size());
+  writer.put(event_time_us);
+  writer.put(first_book_update_id);
+  writer.put(last_book_update_id);
+  writer.put(price_exponent);
+  writer.put(qty_exponent);
+  PutLevels(writer, bids);
+  PutLevels(writer, asks);
+  writer.symbol(symbol);
+  return writer.take();
+}
+}  // namespace sbe
@@ -0,0 +1,131 @@
+module;
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+module shm;
+
+namespace shm {
+namespace {
+[[noreturn]] void ThrowErrno(const std::string& what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+}  // namespace
+
+std::array<char, kSymbolSize> make_symbol(const std::string_view symbol) {
+  std::array<char, kSymbolSize> out{};
+  std::copy_n(symbol.begin(), std::min(symbol.size(), kSymbolSize - 1),
+              out.begin());
+  return out;
+}
+
+Publisher::Publisher(const std::string& name) : name_(name) {
+  // Unlink first: readers of a previous run keep their mapping, new readers
+  // find this one.
+  ::shm_unlink(name_.c_str());
+  const int fd =
+      ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0) ThrowErrno("shm_open " + name_);
+  if (::ftruncate(fd, sizeof(Region)) != 0) {
+    ::close(fd);
+    ::shm_unlink(name_.c_str());
+    ThrowErrno("shm size " + name_);
+  }
+  void* mapping = ::mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    ::shm_unlink(name_.c_str());
+    ThrowErrno("shm map " + name_);
+  }
+
+  region_ = new (mapping) Region{};
+  region_->magic = Region::kMagic;
+  region_->version = Region::kVersion;
+  region_->max_books = kMaxBooks;
+  region_->book_depth = kBookDepth;
+  region_->trade_slots = kTradeSlots;
+  region_->heartbeat_ns.store(NowNs(), std::memory_order_relaxed);
+  region_->ready.store(1, std::memory_order_release);
+}
+
+Publisher::~Publisher() {
+  ::munmap(region_, sizeof(Region));
+  ::shm_unlink(name_.c_str());
+}
+
+std::optional<uint32_t> Publisher::slot(const std::string_view symbol) {
+  if (const auto it = slots_.find(symbol); it != slots_.end()) {
+    return it->second;
+  }
+  const uint32_t index = region_->book_count.load(std::memory_order_relaxed);
+  if (index == kMaxBooks) return std::nullopt;
+  region_->symbols[index] = make_symbol(symbol);
+  region_->book_count.store(index + 1, std::memory_order_release);
+  slots_.emplace(symbol, index);
+  return index;
+}
+
+void Publisher::publish_book(const std::string_view symbol,
+                             const int64_t event_ns, const int64_t update_id,
+                             const std::span<const Level> bids,
+                             const std::span<const Level> asks) {
+  const auto index = slot(symbol);
+  if (!index) return;
+  Book book{
+      .symbol = region_->symbols[*index],
+      .event_ns = event_ns,
+      .update_id = update_id,
+      .bid_count = static_cast<uint32_t>(std::min<size_t>(bids.size(),
+                                                          kBookDepth)),
+      .ask_count = static_cast<uint32_t>(std::min<size_t>(asks.size(),
+                                                          kBookDepth)),
+      .bids = {},
+      .asks = {},
+  };
+  std::copy_n(bids.begin(), book.bid_count, book.bids.begin());
+  std::copy_n(asks.begin(), book.ask_count, book.asks.begin());
+  region_->books[*index].store(book);
+}
+
+void Publisher::publish_bbo(const std::string_view symbol,
+                            const int64_t event_ns, const int64_t update_id,
+                            const Level bid, const Level ask) {
+  const auto index = slot(symbol);
+  if (!index) return;
+  region_->bbos[*index].store(Bbo{
+      .event_ns = event_ns, .update_id = update_id, .bid = bid, .ask = ask});
+}
+
+void Publisher::publish_trade(const Trade& trade) {
+  const uint64_t ticket =
+      region_->trade_cursor.load(std::memory_order_relaxed);
+  TradeSlot& slot = region_->trades[ticket % kTradeSlots];
+  slot.sequence.store(2 * ticket + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(&slot.trade, &trade, sizeof(Trade));
+  slot.sequence.store(2 * ticket + 2, std::memory_order_release);
+  region_->trade_cursor.store(ticket + 1, std::memory_order_release);
+}
+
+void Publisher::heartbeat() noexcept {
+  region_->heartbeat_ns.store(NowNs(), std::memory_order_relaxed);
+}
+}  // namespace shm
@@ -0,0 +1,121 @@
+module;
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+module shm;
+
+namespace shm {
+std::string_view symbol_view(const std::array<char, kSymbolSize>& s) {
+  return {s.data(), ::strnlen(s.data(), s.size())};
+}
+
+Reader::Reader(const std::string& name) {
+  const int fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(),
+                            "shm_open " + name);
+  }
+  struct stat st{};
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(Region)) {
+    ::close(fd);
+    throw std::runtime_error("not a market data region: " + name);
+  }
+  void* mapping =
+      ::mmap(nullptr, sizeof(Region), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::system_error(errno, std::generic_category(),
+                            "shm map " + name);
+  }
+  region_ = static_cast<const Region*>(mapping);
+
+  if (region_->ready.load(std::memory_order_acquire) != 1 ||
+      region_->magic != Region::kMagic ||
+      region_->version != Region::kVersion ||
+      region_->max_books != kMaxBooks || region_->book_depth != kBookDepth ||
+      region_->trade_slots != kTradeSlots) {
+    ::munmap(mapping, sizeof(Region));
+    region_ = nullptr;
+    throw std::runtime_error("incompatible market data region: " + name);
+  }
+  trade_position_ = region_->trade_cursor.load(std::memory_order_acquire);
+}
+
+Reader::~Reader() {
+  if (region_ != nullptr) {
+    ::munmap(const_cast<Region*>(region_), sizeof(Region));
+  }
+}
+
+std::vector<std::string> Reader::symbols() const {
+  const uint32_t count = region_->book_count.load(std::memory_order_acquire);
+  std::vector<std::string> out;
+  out.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    out.emplace_back(symbol_view(region_->symbols[i]));
+  }
+  return out;
+}
+
+std::optional<uint32_t> Reader::find(const std::string_view symbol) const {
+  const uint32_t count = region_->book_count.load(std::memory_order_acquire);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (symbol_view(region_->symbols[i]) == symbol) return i;
+  }
+  return std::nullopt;
+}
+
+bool Reader::read_book(const std::string_view symbol, Book& out) const {
+  const auto index = find(symbol);
+  return index && region_->books[*index].load(out);
+}
+
+bool Reader::read_bbo(const std::string_view symbol, Bbo& out) const {
+  const auto index = find(symbol);
+  return index && region_->bbos[*index].load(out);
+}
+
+std::optional<Trade> Reader::next_trade() {
+  while (true) {
+    const uint64_t cursor =
+        region_->trade_cursor.load(std::memory_order_acquire);
+    if (trade_position_ >= cursor) return std::nullopt;
+    if (cursor - trade_position_ > kTradeSlots) {
+      lost_ += cursor - trade_position_ - kTradeSlots;
+      trade_position_ = cursor - kTradeSlots;
+    }
+    const TradeSlot& slot = region_->trades[trade_position_ % kTradeSlots];
+    const uint64_t expected = 2 * trade_position_ + 2;
+    const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before == expected) {
+      Trade trade;
+      std::memcpy(&trade, &slot.trade, sizeof(Trade));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) == expected) {
+        ++trade_position_;
+        return trade;
+      }
+    }
+    // Overwritten by a newer trade while this reader was behind.
+    ++lost_;
+    ++trade_position_;
+  }
+}
+
+int64_t Reader::heartbeat_ns() const noexcept {
+  return region_->heartbeat_ns.load(std::memory_order_relaxed);
+}
+}  // namespace shm
@@ -0,0 +1,87 @@
+module;
+#include <string_view>
+
+#include "boost/asio/awaitable.hpp"
+#include "nlohmann/json.hpp"
+
+module state;
+
+import sbe;
+import telemetry;
+
+namespace state {
+namespace {
+const telemetry::LogSite kParseError(telemetry::LogLevel::kError,
+                                     "JSON parse error: {} (`{}`)");
+const telemetry::LogSite kDecodeError(telemetry::LogLevel::kError,
+                                      "SBE bestBidAsk decode error ({} bytes)");
+}  // namespace
+
+inline void from_json(const nlohmann::json& j, BookTicker& bt) {
+  // {
+  //   "u": 400900217,     // Order book updateId
+  //   "s": "BNBUSDT",     // Symbol
+  //   "b": "25.35190000", // Best bid price
+  //   "B": "31.21000000", // Best bid qty
+  //   "a": "25.36520000", // Best ask price
+  //   "A": "40.66000000"  // Best ask qty
+  // }
+  j.at("s").get_to(bt.symbol);
+  j.at("u").get_to(bt.best.update_id);
+  bt.best.bid_price = std::stod(j.at("b").get<std::string>());
+  bt.best.bid_quantity = std::stod(j.at("B").get<std::string>());
+  bt.best.ask_price = std::stod(j.at("a").get<std::string>());
+  bt.best.ask_quantity = std::stod(j.at("A").get<std::string>());
+}
+
+bool from_sbe(const std::string_view frame, BookTicker& bt) {
+  const auto event = sbe::BestBidAskEvent::wrap(frame);
+  if (!event) return false;
+  const int8_t price_exponent = event->price_exponent();
+  const int8_t qty_exponent = event->qty_exponent();
+  bt.symbol = event->symbol();
+  bt.best = BestBidOffer{
+      .update_id = event->book_update_id(),
+      .bid_price = sbe::decimal(event->bid_price(), price_exponent),
+      .bid_quantity = sbe::decimal(event->bid_qty(), qty_exponent),
+      .ask_price = sbe::decimal(event->ask_price(), price_exponent),
+      .ask_quantity = sbe::decimal(event->ask_qty(), qty_exponent),
+  };
+  return true;
+}
+
+boost::asio::awaitable<void> BookTickerHandler::handle(
+    const nlohmann::json& data) {
+  BookTicker ticker{};
+  try {
+    ticker = data.get<BookTicker>();
+  } catch (const std::exception& e) {
+    telemetry::log(kParseError, e.what(), data.dump());
+    co_return;
+  }
+  publish(ticker);
+  co_return;
+}
+
+boost::asio::awaitable<void> BookTickerHandler::handle_sbe(
+    const std::string_view frame) {
+  BookTicker ticker{};
+  if (!from_sbe(frame, ticker)) {
+    telemetry::log(kDecodeError, frame.size());
+    co_return;
+  }
+  publish(ticker);
+  co_return;
+}
+
+void BookTickerHandler::publish(const BookTicker& ticker) {
+  // Updates may be delivered out of order across reconnects; keep the newest.
+  if (top_of_book_.version() != 0 &&
+      ticker.best.update_id < top_of_book_.load().update_id) {
+    return;
+  }
+
+  top_of_book_.store(ticker.best);
+  subject_.get_observer().on_next(ticker);
+}
+}  // namespace state
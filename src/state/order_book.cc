@@ -1,12 +1,83 @@
 module;
+#include <chrono>
+#include <ranges>
+#include <string>
+#include <string_view>
+
 #include "boost/asio/awaitable.hpp"
 #include "nlohmann/json.hpp"
 #include "spdlog/spdlog.h"
 
 module state;
 
+import sbe;
+import telemetry;
+
 namespace state {
-inline void from_json(const nlohmann::json& j, OrderBookUpdate& obu) {
+namespace {
+struct Metrics {
+  telemetry::Counter& parse_errors = telemetry::metrics().counter(
+      "parse_errors_total", "Messages that failed to parse",
+      R"(source="depthUpdate")");
+  telemetry::Counter& resyncs = telemetry::metrics().counter(
+      "order_book_resyncs_total", "Order book resynchronizations after a gap");
+  telemetry::Histogram& apply = telemetry::metrics().histogram(
+      "order_book_apply_seconds", "Time to apply one depth update");
+};
+
+Metrics& metrics() {
+  static Metrics instance;
+  return instance;
+}
+
+// Pause after a failed snapshot fetch, so error responses (rate limits
+// included) are not answered with a request per update.
+constexpr auto kSnapshotRetryDelay = std::chrono::seconds(1);
+
+// Per-update log statements (see telemetry::log).
+const telemetry::LogSite kParseError(telemetry::LogLevel::kError,
+                                     "JSON parse error: {} (`{}`)");
+const telemetry::LogSite kUpdateReceived(
+    telemetry::LogLevel::kDebug,
+    "Order book update received: first_update_id={} last_update_id={} "
+    "(bids: {}, asks: {})");
+const telemetry::LogSite kBufferedApplied(
+    telemetry::LogLevel::kDebug,
+    "Applied buffered update: new current_update_id={}");
+const telemetry::LogSite kStaleUpdate(
+    telemetry::LogLevel::kWarn,
+    "Stale update ignored: update.last_update_id ({}) < "
+    "current_update_id ({}).");
+const telemetry::LogSite kApplied(telemetry::LogLevel::kDebug,
+                                  "Applied update: new current_update_id={}");
+const telemetry::LogSite kDecodeError(telemetry::LogLevel::kError,
+                                      "SBE depth decode error ({} bytes)");
+
+// [["price", "quantity"], ...] as numbers.
+void ParseLevels(const nlohmann::json& j, std::vector<OrderBookEntry>& out) {
+  out.clear();
+  out.reserve(j.size());
+  for (const auto& level : j) {
+    out.push_back(
+        OrderBookEntry{std::stod(level.at(0).get_ref<const std::string&>()),
+                       std::stod(level.at(1).get_ref<const std::string&>())});
+  }
+}
+
+void DecodeLevels(const sbe::Group<sbe::LevelEntry>& levels,
+                  const int8_t price_exponent, const int8_t qty_exponent,
+                  std::vector<OrderBookEntry>& out) {
+  out.clear();
+  out.reserve(levels.size());
+  for (const sbe::LevelEntry level : levels) {
+    out.push_back(
+        OrderBookEntry{sbe::decimal(level.price(), price_exponent),
+                       sbe::decimal(level.qty(), qty_exponent)});
+  }
+}
+}  // namespace
+
+void from_json(const nlohmann::json& j, OrderBookUpdate& obu) {
   // {
   //   "e": "depthUpdate", // Event type
   //   "E": 1672515782136, // Event time
@@ -30,31 +101,80 @@ inline void from_json(const nlohmann::json& j, OrderBookUpdate& obu) {
   j.at("E").get_to(obu.timestamp);
   j.at("U").get_to(obu.first_update_id);
   j.at("u").get_to(obu.last_update_id);
-  j.at("b").get_to(obu.bids);
-  j.at("a").get_to(obu.asks);
+  ParseLevels(j.at("b"), obu.bids);
+  ParseLevels(j.at("a"), obu.asks);
 }
 
-void OrderBookHandler::apply_update(const OrderBookUpdate& update) {
+bool from_sbe(const std::string_view frame, OrderBookUpdate& obu) {
+  const auto event = sbe::DepthDiffEvent::wrap(frame);
+  if (!event) return false;
+  obu.symbol = event->symbol();
+  obu.timestamp = static_cast<uint64_t>(event->event_time_us() / 1000);
+  obu.first_update_id = event->first_book_update_id();
+  obu.last_update_id = event->last_book_update_id();
+  DecodeLevels(event->bids(), event->price_exponent(), event->qty_exponent(),
+               obu.bids);
+  DecodeLevels(event->asks(), event->price_exponent(), event->qty_exponent(),
+               obu.asks);
+  return true;
+}
+
+void OrderBookHandler::publish_reset() const {
+  // Until synchronized the book is partial; the sync publishes a reset.
+  if (!initialized_) return;
+  OrderBookDelta snapshot_delta{.reset = true};
+  snapshot_delta.bids =
+      std::ranges::to<std::vector>(order_book_.bids | std::views::values);
+  snapshot_delta.asks =
+      std::ranges::to<std::vector>(order_book_.asks | std::views::values);
+  delta_subject_.get_observer().on_next(snapshot_delta);
+}
+
+OrderBookDelta OrderBookHandler::apply_update(const OrderBookUpdate& update) {
+  // The changed levels are exactly the update's.
+  OrderBookDelta delta{.bids = update.bids, .asks = update.asks};
   // Process bids
   for (const auto& bid : update.bids) {
-    const double price = std::stod(bid[0]);
-    if (const double qty = std::stod(bid[1]); qty == 0.0) {
-      order_book_.bids.erase(price);
+    if (bid.quantity == 0.0) {
+      order_book_.bids.erase(bid.price);
     } else {
-      order_book_.bids[price] = OrderBookEntry{price, qty};
+      order_book_.bids[bid.price] = bid;
     }
   }
   // Process asks
   for (const auto& ask : update.asks) {
-    const double price = std::stod(ask[0]);
-    if (const double qty = std::stod(ask[1]); qty == 0.0) {
-      order_book_.asks.erase(price);
+    if (ask.quantity == 0.0) {
+      order_book_.asks.erase(ask.price);
     } else {
-      order_book_.asks[price] = OrderBookEntry{price, qty};
+      order_book_.asks[ask.price] = ask;
     }
   }
   // Update the current update id to that of the processed event.
   current_update_id_ = update.last_update_id;
+  if (order_book_.symbol != update.symbol) order_book_.symbol = update.symbol;
+  order_book_.timestamp = update.timestamp;
+  order_book_.last_update_id = update.last_update_id;
+  return delta;
+}
+
+void OrderBookHandler::apply_snapshot(
+    const exchange::OrderBookSnapshot& snapshot) {
+  order_book_.bids.clear();
+  order_book_.asks.clear();
+  for (const auto& bid : snapshot.bids) {
+    const double price = std::stod(bid[0]);
+    const double qty = std::stod(bid[1]);
+    if (qty == 0.0) continue;
+    order_book_.bids[price] = OrderBookEntry{price, qty};
+  }
+  for (const auto& ask : snapshot.asks) {
+    const double price = std::stod(ask[0]);
+    const double qty = std::stod(ask[1]);
+    if (qty == 0.0) continue;
+    order_book_.asks[price] = OrderBookEntry{price, qty};
+  }
+  current_update_id_ = snapshot.last_update_id;
+  order_book_.last_update_id = snapshot.last_update_id;
 }
 
 boost::asio::awaitable<void> OrderBookHandler::handle(
@@ -63,53 +183,75 @@ boost::asio::awaitable<void> OrderBookHandler::handle(
   try {
     update = data.get<OrderBookUpdate>();
   } catch (const std::exception& e) {
-    spdlog::error("JSON parse error: {} (`{}`)", e.what(), data.dump());
+    metrics().parse_errors.add();
+    telemetry::log(kParseError, e.what(), data.dump());
     co_return;
   }
+  auto& tracer = telemetry::tracer();
+  tracer.set_event("depthUpdate", static_cast<int64_t>(update.timestamp));
+  tracer.mark(telemetry::Stage::kParse);
+  co_await handle_update(std::move(update));
+}
 
-  spdlog::debug(
-      "Order book update received: "
-      "first_update_id={} last_update_id={} "
-      "(bids: {}, asks: {})",
-      update.first_update_id, update.last_update_id, update.bids.size(),
-      update.asks.size());
+boost::asio::awaitable<void> OrderBookHandler::handle_sbe(
+    const std::string_view frame) {
+  OrderBookUpdate update{};
+  if (!from_sbe(frame, update)) {
+    metrics().parse_errors.add();
+    telemetry::log(kDecodeError, frame.size());
+    co_return;
+  }
+  auto& tracer = telemetry::tracer();
+  tracer.set_event("depthUpdate", static_cast<int64_t>(update.timestamp));
+  tracer.mark(telemetry::Stage::kParse);
+  co_await handle_update(std::move(update));
+}
+
+boost::asio::awaitable<void> OrderBookHandler::handle_update(
+    OrderBookUpdate update) {
+  auto& tracer = telemetry::tracer();
+  telemetry::log(kUpdateReceived, update.first_update_id,
+                 update.last_update_id, update.bids.size(), update.asks.size());
 
   if (!initialized_) {
     // Buffer the update until the snapshot is applied.
     buffered_updates_.push_back(update);
 
-    if (!snapshot_requested_) {
+    if (!snapshot_requested_ &&
+        std::chrono::steady_clock::now() >= snapshot_retry_at_) {
       // Record the U from the first event.
       first_event_U_ = update.first_update_id;
       snapshot_requested_ = true;
 
-      // Fetch a full snapshot.
-      auto snapshot = co_await api_.get_orderbook_snapshot(update.symbol);
-      // Ensure the snapshot's update id is >= the first event's U.
-      while (snapshot.last_update_id < first_event_U_) {
-        spdlog::warn(
-            "Snapshot last_update_id ({}) is less than first event U ({}). "
-            "Refetching snapshot...",
-            snapshot.last_update_id, first_event_U_);
+      // Fetch a full snapshot. Other messages are traced while it is in
+      // flight, so this one's span is put back afterwards.
+      const telemetry::MessageSpan span = tracer.current_message();
+      exchange::OrderBookSnapshot snapshot;
+      try {
         snapshot = co_await api_.get_orderbook_snapshot(update.symbol);
+        // Ensure the snapshot's update id is >= the first event's U.
+        while (snapshot.last_update_id < first_event_U_) {
+          spdlog::warn(
+              "Snapshot last_update_id ({}) is less than first event U ({}). "
+              "Refetching snapshot...",
+              snapshot.last_update_id, first_event_U_);
+          snapshot = co_await api_.get_orderbook_snapshot(update.symbol);
+        }
+        tracer.restore_message(span);
+      } catch (const std::exception& e) {
+        tracer.restore_message(span);
+        // Error response, timeout or lost API connection: start over from
+        // the next update instead of waiting for this fetch forever.
+        spdlog::error("Order book snapshot failed: {}. Retrying.", e.what());
+        buffered_updates_.clear();
+        snapshot_requested_ = false;
+        snapshot_retry_at_ =
+            std::chrono::steady_clock::now() + kSnapshotRetryDelay;
+        co_return;
       }
 
       // Initialize the local order book with the snapshot.
-      order_book_.bids.clear();
-      order_book_.asks.clear();
-      for (const auto& bid : snapshot.bids) {
-        const double price = std::stod(bid[0]);
-        const double qty = std::stod(bid[1]);
-        if (qty == 0.0) continue;
-        order_book_.bids[price] = OrderBookEntry{price, qty};
-      }
-      for (const auto& ask : snapshot.asks) {
-        const double price = std::stod(ask[0]);
-        const double qty = std::stod(ask[1]);
-        if (qty == 0.0) continue;
-        order_book_.asks[price] = OrderBookEntry{price, qty};
-      }
-      current_update_id_ = snapshot.last_update_id;
+      apply_snapshot(snapshot);
       spdlog::info("Order book snapshot applied with last_update_id={}",
                    current_update_id_);
 
@@ -124,14 +266,15 @@ boost::asio::awaitable<void> OrderBookHandler::handle(
       for (const auto& buffered_update : buffered_updates_) {
         // Ignore any update that is already stale.
         if (buffered_update.last_update_id < current_update_id_) continue;
-        // If the update’s first update id is greater than our current update
-        // id, there is a gap: restart the sync process.
-        if (buffered_update.first_update_id > current_update_id_) {
+        // If the update does not start at or before the next update id,
+        // there is a gap: restart the sync process.
+        if (buffered_update.first_update_id > current_update_id_ + 1) {
           spdlog::error(
               "Gap in buffered updates detected: first_update_id {} > "
-              "current_update_id {}. Restarting sync.",
+              "current_update_id {} + 1. Restarting sync.",
               buffered_update.first_update_id, current_update_id_);
           // Reset the state.
+          metrics().resyncs.add();
           initialized_ = false;
           buffered_updates_.clear();
           order_book_.bids.clear();
@@ -140,29 +283,31 @@ boost::asio::awaitable<void> OrderBookHandler::handle(
           co_return;
         }
         apply_update(buffered_update);
-        spdlog::debug("Applied buffered update: new current_update_id={}",
-                      current_update_id_);
+        telemetry::log(kBufferedApplied, current_update_id_);
       }
       buffered_updates_.clear();
       initialized_ = true;
+
+      // Let incremental consumers rebuild from the synchronized book.
+      publish_reset();
     }
     co_return;
   }
 
   // Already initialized – process the update directly.
   if (update.last_update_id < current_update_id_) {
-    spdlog::warn(
-        "Stale update ignored: update.last_update_id ({}) < "
-        "current_update_id ({}).",
-        update.last_update_id, current_update_id_);
+    telemetry::log(kStaleUpdate, update.last_update_id, current_update_id_);
     co_return;
   }
-  if (update.first_update_id > current_update_id_) {
+  // Consecutive updates have U == previous u + 1; redundant feeds may also
+  // deliver overlapping ranges (see exchange::FeedArbiter).
+  if (update.first_update_id > current_update_id_ + 1) {
     spdlog::error(
         "Missing updates: update.first_update_id ({}) > current_update_id "
-        "({}). Restarting sync.",
+        "({}) + 1. Restarting sync.",
         update.first_update_id, current_update_id_);
     // Reset state for a full re-sync.
+    metrics().resyncs.add();
     initialized_ = false;
     buffered_updates_.clear();
     order_book_.bids.clear();
@@ -170,11 +315,16 @@ boost::asio::awaitable<void> OrderBookHandler::handle(
     snapshot_requested_ = false;
     co_return;
   }
-  apply_update(update);
-  spdlog::debug("Applied update: new current_update_id={}", current_update_id_);
+  const int64_t apply_start = telemetry::monotonic_ns();
+  const OrderBookDelta delta = apply_update(update);
+  tracer.mark(telemetry::Stage::kHandle);
+  metrics().apply.record(telemetry::monotonic_ns() - apply_start);
+  telemetry::log(kApplied, current_update_id_);
 
   // Publish the update so that other components can use it.
+  delta_subject_.get_observer().on_next(delta);
   subject_.get_observer().on_next(order_book_);
+  tracer.mark(telemetry::Stage::kPublish);
   co_return;
 }
 }  // namespace state
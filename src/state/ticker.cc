@@ -0,0 +1,102 @@
+module;
+#include <cstdlib>
+
+#include "boost/asio/awaitable.hpp"
+#include "nlohmann/json.hpp"
+
+module state;
+
+import telemetry;
+
+namespace state {
+namespace {
+// Parse a decimal string field without copying it out of the document.
+double decimal_at(const nlohmann::json& j, const char* key) {
+  const auto& value = j.at(key).get_ref<const std::string&>();
+  return std::strtod(value.c_str(), nullptr);
+}
+
+const telemetry::LogSite kParseError(telemetry::LogLevel::kError,
+                                     "JSON parse error: {} (`{}`)");
+}  // namespace
+
+boost::asio::awaitable<void> AllMarketTickerHandler::handle(
+    const nlohmann::json& data) {
+  // [
+  //   {
+  //     "e": "24hrMiniTicker",  // Event type
+  //     "E": 1672515782136,     // Event time
+  //     "s": "BNBBTC",          // Symbol
+  //     "c": "0.0025",          // Close price
+  //     "o": "0.0010",          // Open price
+  //     "h": "0.0025",          // High price
+  //     "l": "0.0010",          // Low price
+  //     "v": "10000",           // Total traded base asset volume
+  //     "q": "18"               // Total traded quote asset volume
+  //   },
+  //   ...
+  // ]
+  // `!ticker@arr` elements carry the same fields plus a few more.
+  batch_.rows.clear();
+  try {
+    for (const auto& element : data) {
+      // Parse the whole element before touching the table, so a malformed
+      // one leaves its row as it was.
+      const auto& symbol = element.at("s").get_ref<const std::string&>();
+      const int64_t event_time = element.at("E").get<int64_t>();
+      const double close = decimal_at(element, "c");
+      const double open = decimal_at(element, "o");
+      const double high = decimal_at(element, "h");
+      const double low = decimal_at(element, "l");
+      const double base_volume = decimal_at(element, "v");
+      const double quote_volume = decimal_at(element, "q");
+
+      auto [it, inserted] =
+          ids_.try_emplace(symbol, static_cast<uint32_t>(ids_.size()));
+      const auto& [name, id] = *it;
+      if (inserted) {
+        event_time_.push_back(0);
+        close_.push_back(0.0);
+        open_.push_back(0.0);
+        high_.push_back(0.0);
+        low_.push_back(0.0);
+        base_volume_.push_back(0.0);
+        quote_volume_.push_back(0.0);
+      }
+
+      event_time_[id] = event_time;
+      if (!inserted && close == close_[id] && open == open_[id] &&
+          high == high_[id] && low == low_[id] &&
+          base_volume == base_volume_[id] &&
+          quote_volume == quote_volume_[id]) {
+        continue;  // nothing visible changed
+      }
+      close_[id] = close;
+      open_[id] = open;
+      high_[id] = high;
+      low_[id] = low;
+      base_volume_[id] = base_volume;
+      quote_volume_[id] = quote_volume;
+
+      batch_.rows.push_back(TickerRow{
+          .id = id,
+          .symbol = name,
+          .event_time = event_time,
+          .close = close,
+          .open = open,
+          .high = high,
+          .low = low,
+          .base_volume = base_volume,
+          .quote_volume = quote_volume,
+      });
+    }
+  } catch (const std::exception& e) {
+    // The rows committed so far are in the table already: publish them so
+    // the watchlist does not miss their changes.
+    telemetry::log(kParseError, e.what(), data.dump());
+  }
+
+  if (!batch_.rows.empty()) subject_.get_observer().on_next(batch_);
+  co_return;
+}
+}  // namespace state
@@ -1,12 +1,41 @@
 module;
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include "boost/asio/awaitable.hpp"
 #include "nlohmann/json.hpp"
 #include "spdlog/spdlog.h"
 
 module state;
 
+import sbe;
+import telemetry;
+
 namespace state {
-inline void from_json(const nlohmann::json& j, Trade& t) {
+namespace {
+struct Metrics {
+  telemetry::Counter& parse_errors = telemetry::metrics().counter(
+      "parse_errors_total", "Messages that failed to parse",
+      R"(source="aggTrade")");
+  telemetry::Counter& decode_errors = telemetry::metrics().counter(
+      "parse_errors_total", "Messages that failed to parse",
+      R"(source="trade")");
+};
+
+Metrics& metrics() {
+  static Metrics instance;
+  return instance;
+}
+
+const telemetry::LogSite kParseError(telemetry::LogLevel::kError,
+                                     "JSON parse error: {} (`{}`)");
+const telemetry::LogSite kDecodeError(telemetry::LogLevel::kError,
+                                      "SBE trade decode error ({} bytes)");
+}  // namespace
+
+void from_json(const nlohmann::json& j, Trade& t) {
   // {
   //   "e": "aggTrade",    // Event type
   //   "E": 1672515782136, // Event time
@@ -32,16 +61,69 @@ inline void from_json(const nlohmann::json& j, Trade& t) {
   j.at("m").get_to(t.is_buyer_market_maker);
 }
 
+bool from_sbe(const std::string_view frame, std::vector<Trade>& trades) {
+  const auto event = sbe::TradesEvent::wrap(frame);
+  if (!event) return false;
+  using namespace std::chrono;
+  const sys_time event_time{microseconds{event->event_time_us()}};
+  const sys_time trade_time{microseconds{event->transact_time_us()}};
+  trades.clear();
+  for (const sbe::TradeEntry entry : event->trades()) {
+    trades.push_back(Trade{
+        .event_time = event_time,
+        .symbol = std::string(event->symbol()),
+        .trade_id = static_cast<uint64_t>(entry.id()),
+        .price = sbe::decimal(entry.price(), event->price_exponent()),
+        .quantity = sbe::decimal(entry.qty(), event->qty_exponent()),
+        .first_trade_id = static_cast<uint64_t>(entry.id()),
+        .last_trade_id = static_cast<uint64_t>(entry.id()),
+        .trade_time = trade_time,
+        .is_buyer_market_maker = entry.is_buyer_maker(),
+    });
+  }
+  return true;
+}
+
 boost::asio::awaitable<void> TradeHandler::handle(const nlohmann::json& data) {
   Trade trade{};
   try {
     trade = data.get<Trade>();
   } catch (const std::exception& e) {
-    spdlog::error("JSON parse error: {} (`{}`)", e.what(), data.dump());
+    metrics().parse_errors.add();
+    telemetry::log(kParseError, e.what(), data.dump());
     co_return;
   }
+  auto& tracer = telemetry::tracer();
+  tracer.set_event("aggTrade",
+                   std::chrono::duration_cast<std::chrono::milliseconds>(
+                       trade.event_time.time_since_epoch())
+                       .count());
+  tracer.mark(telemetry::Stage::kParse);
 
   subject_.get_observer().on_next(trade);
+  tracer.mark(telemetry::Stage::kPublish);
+  co_return;
+}
+
+boost::asio::awaitable<void> TradeHandler::handle_sbe(
+    const std::string_view frame) {
+  if (!from_sbe(frame, sbe_trades_)) {
+    metrics().decode_errors.add();
+    telemetry::log(kDecodeError, frame.size());
+    co_return;
+  }
+  if (sbe_trades_.empty()) co_return;
+  auto& tracer = telemetry::tracer();
+  tracer.set_event("trade",
+                   std::chrono::duration_cast<std::chrono::milliseconds>(
+                       sbe_trades_.front().event_time.time_since_epoch())
+                       .count());
+  tracer.mark(telemetry::Stage::kParse);
+
+  for (const Trade& trade : sbe_trades_) {
+    subject_.get_observer().on_next(trade);
+  }
+  tracer.mark(telemetry::Stage::kPublish);
   co_return;
 }
 }  // namespace state
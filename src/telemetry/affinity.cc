@@ -0,0 +1,25 @@
+module;
+#include <pthread.h>
+#include <sched.h>
+
+#include <cstring>
+
+#include "spdlog/spdlog.h"
+
+module telemetry;
+
+namespace telemetry {
+bool pin_current_thread(const int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (const int error =
+          ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+      error != 0) {
+    spdlog::error("cannot pin thread to cpu {}: {}", cpu,
+                  std::strerror(error));
+    return false;
+  }
+  return true;
+}
+}  // namespace telemetry
@@ -0,0 +1,30 @@
+module;
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+module telemetry;
+
+// Replaces the global allocation functions of every binary this object is
+// linked into, counting calls to operator new.
+namespace {
+std::atomic<uint64_t> g_allocations{0};
+}  // namespace
+
+namespace telemetry {
+uint64_t allocation_count() noexcept {
+  return g_allocations.load(std::memory_order_relaxed);
+}
+}  // namespace telemetry
+
+void* operator new(const std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc{};
+}
+void* operator new[](const std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,364 @@
+module;
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+module telemetry;
+
+namespace telemetry {
+namespace {
+// File layout: magic and version, then entries that each start with an
+// EntryKind byte. A site is always written before the first event using it.
+//   kSite:    u32 id, u8 level, u32 length, format bytes
+//   kEvent:   u32 thread, then the ring record (u32 size, u32 site, i64 time,
+//             arguments)
+//   kDropped: u32 thread, u64 records dropped by that thread so far
+constexpr char kMagic[8] = {'B', 'T', 'B', 'I', 'N', 'L', 'O', 'G'};
+constexpr uint64_t kVersion = 1;
+enum class EntryKind : uint8_t { kSite = 1, kEvent = 2, kDropped = 3 };
+
+// Site id of the filler record written when a record does not fit before the
+// end of the ring.
+constexpr uint32_t kPadding = UINT32_MAX;
+
+constexpr size_t Align8(const size_t n) { return (n + 7) & ~size_t{7}; }
+
+template <typename T>
+void Append(std::vector<char>& out, const T& value) {
+  const auto* bytes = reinterpret_cast<const char*>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+template <typename T>
+T Load(const char* data) {
+  T value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+struct Sites {
+  std::mutex mutex;
+  std::vector<const LogSite*> list;  // by id; sites are static
+};
+
+Sites& sites() {
+  static Sites instance;
+  return instance;
+}
+
+// Byte ring with one producer (the owning thread) and one consumer (the
+// writer thread). Records are 8-aligned and never wrap: one that does not fit
+// before the end is preceded by a padding record.
+struct Ring {
+  Ring(const size_t capacity, const uint32_t thread)
+      : data(std::bit_ceil(capacity)), thread(thread) {}
+
+  char* reserve(const size_t size) noexcept {
+    const size_t capacity = data.size();
+    const uint64_t h = head.load(std::memory_order_relaxed);
+    const uint64_t t = tail.load(std::memory_order_acquire);
+    const size_t offset = h & (capacity - 1);
+    const size_t skip = capacity - offset < size ? capacity - offset : 0;
+    if (size + skip > capacity - (h - t)) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    if (skip != 0) {
+      const uint32_t header[2] = {static_cast<uint32_t>(skip), kPadding};
+      std::memcpy(data.data() + offset, header, sizeof(header));
+    }
+    pending = h + skip;
+    return data.data() + (pending & (capacity - 1));
+  }
+
+  void commit(const size_t size) noexcept {
+    head.store(pending + size, std::memory_order_release);
+  }
+
+  // Appends kEvent entries for everything published so far to `out`.
+  bool drain(std::vector<char>& out) {
+    const size_t mask = data.size() - 1;
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    const uint64_t h = head.load(std::memory_order_acquire);
+    if (t == h) return false;
+    while (t < h) {
+      const char* record = data.data() + (t & mask);
+      const auto size = Load<uint32_t>(record);
+      if (Load<uint32_t>(record + sizeof(uint32_t)) != kPadding) {
+        out.push_back(static_cast<char>(EntryKind::kEvent));
+        Append(out, thread);
+        out.insert(out.end(), record, record + size);
+      }
+      t += Align8(size);
+    }
+    tail.store(t, std::memory_order_release);
+    return true;
+  }
+
+  std::vector<char> data;
+  const uint32_t thread;
+  alignas(64) std::atomic<uint64_t> head{0};
+  uint64_t pending = 0;  // producer only
+  alignas(64) std::atomic<uint64_t> tail{0};
+  std::atomic<uint64_t> dropped{0};
+  uint64_t reported_dropped = 0;  // writer only
+};
+
+class BinaryLog {
+ public:
+  BinaryLog(std::ofstream out, const BinaryLogOptions& options)
+      : out_(std::move(out)),
+        ring_bytes_(options.ring_bytes),
+        dropped_metric_(metrics().counter(
+            "log_records_dropped_total",
+            "Binary log records dropped because a thread's ring was full")),
+        thread_([this, cpu = options.cpu](const std::stop_token stop) {
+          if (cpu >= 0) pin_current_thread(cpu);
+          run(stop);
+        }) {}
+
+  std::shared_ptr<Ring> add_ring() {
+    std::lock_guard lock(mutex_);
+    rings_.push_back(std::make_shared<Ring>(ring_bytes_, next_thread_++));
+    return rings_.back();
+  }
+
+  void count_drop() noexcept { dropped_metric_.add(); }
+
+  void stop() {
+    thread_.request_stop();
+    if (thread_.joinable()) thread_.join();
+  }
+
+ private:
+  void run(const std::stop_token& stop) {
+    while (!stop.stop_requested()) {
+      if (!drain()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    drain();
+  }
+
+  // One pass over all rings; returns whether anything was written.
+  bool drain() {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+      std::lock_guard lock(mutex_);
+      rings = rings_;
+    }
+    events_.clear();
+    for (const auto& ring : rings) {
+      ring->drain(events_);
+      const uint64_t dropped = ring->dropped.load(std::memory_order_relaxed);
+      if (dropped != ring->reported_dropped) {
+        ring->reported_dropped = dropped;
+        events_.push_back(static_cast<char>(EntryKind::kDropped));
+        Append(events_, ring->thread);
+        Append(events_, dropped);
+      }
+    }
+    if (events_.empty()) return false;
+
+    // Every site an event refers to was registered before the event was
+    // published, so reading the list after draining covers them all.
+    definitions_.clear();
+    {
+      auto& [mutex, list] = sites();
+      std::lock_guard lock(mutex);
+      for (; sites_written_ < list.size(); ++sites_written_) {
+        const LogSite& site = *list[sites_written_];
+        definitions_.push_back(static_cast<char>(EntryKind::kSite));
+        Append(definitions_, site.id());
+        Append(definitions_, site.level());
+        Append(definitions_, static_cast<uint32_t>(site.format().size()));
+        definitions_.insert(definitions_.end(), site.format().begin(),
+                            site.format().end());
+      }
+    }
+    out_.write(definitions_.data(),
+               static_cast<std::streamsize>(definitions_.size()));
+    out_.write(events_.data(), static_cast<std::streamsize>(events_.size()));
+    out_.flush();
+
+    // Forget rings of exited threads once they are empty.
+    rings.clear();
+    std::lock_guard lock(mutex_);
+    std::erase_if(rings_, [](const std::shared_ptr<Ring>& ring) {
+      return ring.use_count() == 1 &&
+             ring->tail.load(std::memory_order_relaxed) ==
+                 ring->head.load(std::memory_order_acquire);
+    });
+    return true;
+  }
+
+  std::ofstream out_;
+  const size_t ring_bytes_;
+  Counter& dropped_metric_;
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  uint32_t next_thread_ = 0;
+  size_t sites_written_ = 0;  // writer only
+  std::vector<char> definitions_;
+  std::vector<char> events_;
+  std::jthread thread_;  // last: starts once the members above exist
+};
+
+std::atomic<BinaryLog*> active_log{nullptr};
+
+thread_local std::shared_ptr<Ring> local_ring;
+// Whether the record being written on this thread goes to `local_ring`.
+thread_local bool local_binary = false;
+// Formatting buffer when the binary log is off.
+thread_local std::vector<char> local_record;
+
+std::string ArgToString(const log_detail::ArgType type, const char* data) {
+  using log_detail::ArgType;
+  switch (type) {
+    case ArgType::kInt:
+      return std::to_string(Load<int64_t>(data));
+    case ArgType::kUint:
+      return std::to_string(Load<uint64_t>(data));
+    case ArgType::kDouble:
+      return std::format("{}", Load<double>(data));
+    case ArgType::kBool:
+      return Load<uint64_t>(data) != 0 ? "true" : "false";
+    case ArgType::kString:
+      break;
+  }
+  return {};
+}
+}  // namespace
+
+LogSite::LogSite(const LogLevel level, const std::string_view format)
+    : level_(level), format_(format) {
+  auto& [mutex, list] = sites();
+  std::lock_guard lock(mutex);
+  id_ = static_cast<uint32_t>(list.size());
+  list.push_back(this);
+}
+
+bool start_binary_log(const std::string& path,
+                      const BinaryLogOptions& options) {
+  static std::mutex mutex;
+  static std::unique_ptr<BinaryLog> instance;
+  std::lock_guard lock(mutex);
+  if (instance != nullptr) return false;
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) return false;
+  out.write(kMagic, sizeof(kMagic));
+  out.write(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+  instance = std::make_unique<BinaryLog>(std::move(out), options);
+  active_log.store(instance.get(), std::memory_order_release);
+  return true;
+}
+
+void stop_binary_log() {
+  // The log object stays alive: threads may still hold their rings.
+  if (BinaryLog* log = active_log.exchange(nullptr)) log->stop();
+}
+
+bool log_enabled(const LogLevel level) noexcept {
+  return spdlog::should_log(static_cast<spdlog::level::level_enum>(level));
+}
+
+std::string format_log(const std::string_view format,
+                       const std::span<const char> args) {
+  using log_detail::ArgType;
+  std::vector<std::string> values;
+  for (size_t i = 0; i < args.size();) {
+    const auto type = static_cast<ArgType>(args[i++]);
+    if (type == ArgType::kString) {
+      if (i + sizeof(uint32_t) > args.size()) break;
+      const auto size = Load<uint32_t>(args.data() + i);
+      i += sizeof(uint32_t);
+      if (i + size > args.size()) break;
+      values.emplace_back(args.data() + i, size);
+      i += size;
+    } else {
+      if (i + sizeof(uint64_t) > args.size()) break;
+      values.push_back(ArgToString(type, args.data() + i));
+      i += sizeof(uint64_t);
+    }
+  }
+
+  std::string out;
+  out.reserve(format.size());
+  size_t next = 0;
+  for (size_t i = 0; i < format.size(); ++i) {
+    const char c = format[i];
+    const bool doubled = i + 1 < format.size() && format[i + 1] == c;
+    if ((c == '{' || c == '}') && doubled) {
+      out += c;
+      ++i;
+    } else if (c == '{') {
+      const size_t close = format.find('}', i);
+      if (close == std::string_view::npos) break;
+      out += next < values.size() ? values[next++] : "{}";
+      i = close;
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+namespace log_detail {
+char* begin_record(const LogSite& site, const size_t size) noexcept {
+  char* record = nullptr;
+  local_binary = false;
+  if (BinaryLog* log = active_log.load(std::memory_order_acquire)) {
+    try {
+      if (local_ring == nullptr) local_ring = log->add_ring();
+    } catch (...) {
+      return nullptr;
+    }
+    record = local_ring->reserve(Align8(size));
+    if (record == nullptr) {
+      log->count_drop();
+      return nullptr;
+    }
+    local_binary = true;
+  } else {
+    try {
+      local_record.resize(size);
+    } catch (...) {
+      return nullptr;
+    }
+    record = local_record.data();
+  }
+  const uint32_t header[2] = {static_cast<uint32_t>(size), site.id()};
+  const int64_t time = now_ns();
+  std::memcpy(record, header, sizeof(header));
+  std::memcpy(record + sizeof(header), &time, sizeof(time));
+  return record + kHeaderSize;
+}
+
+void end_record(const LogSite& site, const size_t size) noexcept {
+  if (local_binary) {
+    local_ring->commit(Align8(size));
+    return;
+  }
+  try {
+    const std::string message = format_log(
+        site.format(), std::span(local_record).subspan(kHeaderSize));
+    spdlog::log(static_cast<spdlog::level::level_enum>(site.level()), "{}",
+                message);
+  } catch (...) {
+    // Logging must not throw into the hot path.
+  }
+}
+}  // namespace log_detail
+}  // namespace telemetry
@@ -0,0 +1,63 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+module telemetry;
+
+namespace telemetry {
+uint64_t Histogram::upper_bound(const size_t index) noexcept {
+  if (index < kSub) return index;
+  const size_t shift = index / kSub - 1;
+  return (((index % kSub) + kSub + 1) << shift) - 1;
+}
+
+int64_t Histogram::percentile(const double q) const noexcept {
+  const uint64_t total = count();
+  if (total == 0) return 0;
+  const auto rank = static_cast<uint64_t>(
+      std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(total)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    seen += counts_[i].load(std::memory_order_relaxed);
+    if (seen >= std::max<uint64_t>(rank, 1)) {
+      return static_cast<int64_t>(std::min(upper_bound(i), max_.load()));
+    }
+  }
+  return max();
+}
+
+uint64_t Histogram::count() const noexcept {
+  uint64_t total = 0;
+  for (const auto& count : counts_) {
+    total += count.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+void Histogram::reset() noexcept {
+  for (auto& count : counts_) count.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+void ClockOffset::add_sample(const int64_t sent_ns, const int64_t server_ns,
+                             const int64_t received_ns) noexcept {
+  const int64_t rtt = received_ns - sent_ns;
+  if (rtt < 0) return;
+  const Sample sample{
+      .offset_ns = sent_ns + rtt / 2 - server_ns,
+      .rtt_ns = rtt,
+  };
+
+  std::lock_guard lock(mutex_);
+  samples_[samples_count_++ % kWindow] = sample;
+  const auto used = std::min(samples_count_, kWindow);
+  const auto best = std::ranges::min_element(
+      samples_.begin(), samples_.begin() + used, {}, &Sample::rtt_ns);
+  offset_ns_.store(best->offset_ns, std::memory_order_relaxed);
+  rtt_ns_.store(best->rtt_ns, std::memory_order_relaxed);
+}
+}  // namespace telemetry
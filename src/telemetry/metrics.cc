@@ -0,0 +1,209 @@
+module;
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <format>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+module telemetry;
+
+namespace telemetry {
+// One thread's counter values. Only the owning thread writes; readers sum
+// all shards under the registry lock.
+struct Registry::Shard {
+  std::array<std::atomic<uint64_t>, kMaxCounters> values{};
+};
+
+// Holds the calling thread's shard, registered on first use, and folds it
+// into the retired totals when the thread exits.
+struct ShardOwner {
+  Registry::Shard* shard = nullptr;
+  ~ShardOwner() {
+    if (shard != nullptr) metrics().retire(shard);
+  }
+};
+
+namespace {
+thread_local ShardOwner shard_owner;
+}  // namespace
+
+void Counter::add(const uint64_t n) noexcept {
+  auto& value = metrics().local_shard().values[id_];
+  value.store(value.load(std::memory_order_relaxed) + n,
+              std::memory_order_relaxed);
+}
+
+uint64_t Counter::value() const { return metrics().counter_value(id_); }
+
+Registry::Shard& Registry::local_shard() {
+  if (shard_owner.shard == nullptr) {
+    auto* shard = new Shard();
+    std::lock_guard lock(mutex_);
+    shards_.push_back(shard);
+    shard_owner.shard = shard;
+  }
+  return *shard_owner.shard;
+}
+
+void Registry::retire(Shard* shard) {
+  std::lock_guard lock(mutex_);
+  for (uint32_t i = 0; i < kMaxCounters; ++i) {
+    retired_[i] += shard->values[i].load(std::memory_order_relaxed);
+  }
+  std::erase(shards_, shard);
+  delete shard;
+}
+
+uint64_t Registry::counter_value(const uint32_t id) const {
+  std::lock_guard lock(mutex_);
+  uint64_t total = retired_[id];
+  for (const Shard* shard : shards_) {
+    total += shard->values[id].load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+Registry::Series& Registry::find_or_add(const std::string_view name,
+                                        const std::string_view help,
+                                        const std::string_view labels,
+                                        const MetricType type) {
+  auto it = families_.find(name);
+  if (it == families_.end()) {
+    it = families_
+             .emplace(std::string(name),
+                      Family{.help = std::string(help), .type = type})
+             .first;
+  } else if (it->second.type != type) {
+    spdlog::error("metric {} registered with two types", name);
+  }
+  for (auto& series : it->second.series) {
+    if (series.labels == labels) return series;
+  }
+  return it->second.series.emplace_back(
+      Series{.labels = std::string(labels), .type = type});
+}
+
+Counter& Registry::counter(const std::string_view name,
+                           const std::string_view help,
+                           const std::string_view labels) {
+  std::lock_guard lock(mutex_);
+  if (counters_.empty()) counters_.push_back(Counter(0));  // 0: unassigned
+  Series& series = find_or_add(name, help, labels, MetricType::kCounter);
+  if (series.counter_id == 0) {
+    if (counters_.size() == kMaxCounters) {
+      spdlog::error("too many counters, {}{{{}}} shares the last one", name,
+                    labels);
+      series.counter_id = kMaxCounters - 1;
+    } else {
+      series.counter_id = static_cast<uint32_t>(counters_.size());
+      counters_.push_back(Counter(series.counter_id));
+    }
+  }
+  return counters_[series.counter_id];
+}
+
+Gauge& Registry::gauge(const std::string_view name,
+                       const std::string_view help,
+                       const std::string_view labels) {
+  std::lock_guard lock(mutex_);
+  Series& series = find_or_add(name, help, labels, MetricType::kGauge);
+  if (series.gauge == nullptr) series.gauge = &gauges_.emplace_back();
+  return *series.gauge;
+}
+
+Histogram& Registry::histogram(const std::string_view name,
+                               const std::string_view help,
+                               const std::string_view labels) {
+  std::lock_guard lock(mutex_);
+  Series& series = find_or_add(name, help, labels, MetricType::kHistogram);
+  if (series.histogram == nullptr) {
+    series.histogram = &histograms_.emplace_back();
+  }
+  return *series.histogram;
+}
+
+std::vector<MetricSample> Registry::snapshot() const {
+  std::vector<MetricSample> samples;
+  std::lock_guard lock(mutex_);
+  for (const auto& [name, family] : families_) {
+    for (const auto& series : family.series) {
+      MetricSample sample{
+          .name = name, .labels = series.labels, .type = series.type};
+      switch (series.type) {
+        case MetricType::kCounter: {
+          uint64_t total = retired_[series.counter_id];
+          for (const Shard* shard : shards_) {
+            total += shard->values[series.counter_id].load(
+                std::memory_order_relaxed);
+          }
+          sample.value = static_cast<double>(total);
+          break;
+        }
+        case MetricType::kGauge:
+          sample.value = static_cast<double>(series.gauge->value());
+          break;
+        case MetricType::kHistogram:
+          sample.value = static_cast<double>(series.histogram->count());
+          sample.p50 = series.histogram->percentile(0.5);
+          sample.p99 = series.histogram->percentile(0.99);
+          sample.max = series.histogram->max();
+          sample.sum = series.histogram->sum();
+          break;
+      }
+      samples.push_back(std::move(sample));
+    }
+  }
+  return samples;
+}
+
+std::string Registry::prometheus() const {
+  const auto samples = snapshot();
+  std::lock_guard lock(mutex_);  // for the family help text
+  std::string out;
+  std::string_view family;
+  for (const auto& sample : samples) {
+    const auto braces = [&sample](const std::string_view extra) {
+      std::string labels = sample.labels;
+      if (!extra.empty()) {
+        if (!labels.empty()) labels += ',';
+        labels += extra;
+      }
+      return labels.empty() ? std::string() : "{" + labels + "}";
+    };
+    if (sample.name != family) {
+      family = sample.name;
+      const auto& info = families_.find(sample.name)->second;
+      constexpr std::array<const char*, 3> kTypes = {"counter", "gauge",
+                                                     "summary"};
+      out += std::format("# HELP {} {}\n# TYPE {} {}\n", sample.name,
+                         info.help, sample.name,
+                         kTypes[static_cast<size_t>(sample.type)]);
+    }
+    if (sample.type != MetricType::kHistogram) {
+      out += std::format("{}{} {}\n", sample.name, braces({}), sample.value);
+      continue;
+    }
+    out += std::format("{}{} {:.9f}\n", sample.name,
+                       braces(R"(quantile="0.5")"), sample.p50 / 1e9);
+    out += std::format("{}{} {:.9f}\n", sample.name,
+                       braces(R"(quantile="0.99")"), sample.p99 / 1e9);
+    out += std::format("{}{} {:.9f}\n", sample.name,
+                       braces(R"(quantile="1")"), sample.max / 1e9);
+    out += std::format("{}_sum{} {:.9f}\n", sample.name, braces({}),
+                       static_cast<double>(sample.sum) / 1e9);
+    out += std::format("{}_count{} {}\n", sample.name, braces({}),
+                       sample.value);
+  }
+  return out;
+}
+
+Registry& metrics() noexcept {
+  static Registry instance;
+  return instance;
+}
+}  // namespace telemetry
@@ -0,0 +1,57 @@
+module;
+#include <format>
+#include <string>
+
+#include "boost/asio/buffer.hpp"
+#include "boost/asio/co_spawn.hpp"
+#include "boost/asio/detached.hpp"
+#include "boost/asio/ip/tcp.hpp"
+#include "boost/asio/read_until.hpp"
+#include "boost/asio/this_coro.hpp"
+#include "boost/asio/use_awaitable.hpp"
+#include "boost/asio/write.hpp"
+#include "spdlog/spdlog.h"
+
+module telemetry;
+
+namespace telemetry {
+namespace asio = boost::asio;
+using asio::ip::tcp;
+
+namespace {
+asio::awaitable<void> respond(tcp::socket socket) {
+  try {
+    // The request itself does not matter: every path gets the metrics.
+    std::string request;
+    co_await asio::async_read_until(socket, asio::dynamic_buffer(request),
+                                    "\r\n\r\n", asio::use_awaitable);
+    const std::string body = metrics().prometheus();
+    const std::string response = std::format(
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: {}\r\n"
+        "Connection: close\r\n\r\n{}",
+        body.size(), body);
+    co_await asio::async_write(socket, asio::buffer(response),
+                               asio::use_awaitable);
+  } catch (const std::exception& e) {
+    spdlog::debug("metrics request failed: {}", e.what());
+  }
+}
+}  // namespace
+
+asio::awaitable<void> serve_metrics(const unsigned short port) {
+  const auto executor = co_await asio::this_coro::executor;
+  try {
+    tcp::acceptor acceptor(executor,
+                           {asio::ip::make_address("127.0.0.1"), port});
+    spdlog::info("serving metrics on http://127.0.0.1:{}/metrics", port);
+    while (true) {
+      auto socket = co_await acceptor.async_accept(asio::use_awaitable);
+      asio::co_spawn(executor, respond(std::move(socket)), asio::detached);
+    }
+  } catch (const std::exception& e) {
+    spdlog::error("metrics server on port {} stopped: {}", port, e.what());
+  }
+}
+}  // namespace telemetry
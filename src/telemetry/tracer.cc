@@ -0,0 +1,213 @@
+module;
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+module telemetry;
+
+namespace telemetry {
+namespace {
+constexpr size_t kTimedStages = static_cast<size_t>(Stage::kPresent);
+
+// The message being processed on this thread.
+thread_local MessageSpan current;
+
+enum class RecordKind : uint8_t { kMessage, kFrame };
+
+struct Snapshot {
+  RecordKind kind;
+  const char* label;
+  int64_t event_ns;  // local clock
+  std::array<int64_t, kTimedStages> at;
+};
+}  // namespace
+
+int64_t now_ns() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+int64_t monotonic_ns() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Fixed ring of recent records, written by several threads. Each slot is a
+// small seqlock: the sequence is odd while the slot is being written, and the
+// exporter skips slots that are odd or changed while it copied them.
+struct Tracer::Ring {
+  static constexpr size_t kSlots = 1 << 15;
+
+  struct Slot {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<RecordKind> kind{RecordKind::kMessage};
+    std::atomic<const char*> label{nullptr};
+    std::atomic<int64_t> event_ns{0};
+    std::array<std::atomic<int64_t>, kTimedStages> at{};
+  };
+
+  void push(const Snapshot& snapshot) noexcept {
+    const uint64_t ticket = cursor.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[ticket % kSlots];
+    slot.sequence.store(2 * ticket + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.kind.store(snapshot.kind, std::memory_order_relaxed);
+    slot.label.store(snapshot.label, std::memory_order_relaxed);
+    slot.event_ns.store(snapshot.event_ns, std::memory_order_relaxed);
+    for (size_t i = 0; i < kTimedStages; ++i) {
+      slot.at[i].store(snapshot.at[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(2 * ticket + 2, std::memory_order_release);
+  }
+
+  [[nodiscard]] std::vector<Snapshot> read() const {
+    std::vector<Snapshot> out;
+    out.reserve(kSlots);
+    for (const Slot& slot : slots) {
+      const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+      if (before == 0 || before % 2 == 1) continue;
+      Snapshot snapshot{
+          .kind = slot.kind.load(std::memory_order_relaxed),
+          .label = slot.label.load(std::memory_order_relaxed),
+          .event_ns = slot.event_ns.load(std::memory_order_relaxed),
+      };
+      for (size_t i = 0; i < kTimedStages; ++i) {
+        snapshot.at[i] = slot.at[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) != before) continue;
+      out.push_back(snapshot);
+    }
+    return out;
+  }
+
+  std::atomic<uint64_t> cursor{0};
+  std::array<Slot, kSlots> slots{};
+};
+
+Tracer::Tracer() : ring_(std::make_unique<Ring>()) {}
+
+Tracer::~Tracer() = default;
+
+void Tracer::begin_message(const int64_t receive_ns) noexcept {
+  current = MessageSpan{.active = enabled()};
+  current.at[static_cast<size_t>(Stage::kReceive)] = receive_ns;
+}
+
+void Tracer::set_event(const char* label, const int64_t event_ms) noexcept {
+  current.label = label;
+  current.event_ms = event_ms;
+}
+
+void Tracer::mark(const Stage stage) noexcept {
+  if (!current.active) return;
+  current.at[static_cast<size_t>(stage)] = now_ns();
+}
+
+void Tracer::end_message() noexcept {
+  if (!current.active || current.label == nullptr) return;
+  current.active = false;
+
+  const int64_t event_ns = current.event_ms * 1'000'000 + clock_.offset_ns();
+  // Stages a handler skipped take the time of the stage before them.
+  for (size_t i = 1; i < kTimedStages; ++i) {
+    if (current.at[i] == 0) current.at[i] = current.at[i - 1];
+  }
+  for (size_t i = 0; i < kTimedStages; ++i) {
+    histograms_[i].record(current.at[i] - event_ns);
+  }
+
+  int64_t latest = latest_event_ns_.load(std::memory_order_relaxed);
+  while (event_ns > latest &&
+         !latest_event_ns_.compare_exchange_weak(latest, event_ns,
+                                                 std::memory_order_relaxed)) {
+  }
+  ring_->push(Snapshot{
+      .kind = RecordKind::kMessage,
+      .label = current.label,
+      .event_ns = event_ns,
+      .at = current.at,
+  });
+}
+
+MessageSpan Tracer::current_message() const noexcept { return current; }
+
+void Tracer::restore_message(const MessageSpan& span) noexcept {
+  current = span;
+}
+
+void Tracer::frame_presented() noexcept {
+  if (!enabled()) return;
+  const int64_t latest = latest_event_ns_.load(std::memory_order_relaxed);
+  if (latest == 0) return;  // nothing received yet
+  const int64_t now = now_ns();
+  histograms_[static_cast<size_t>(Stage::kPresent)].record(now - latest);
+  Snapshot snapshot{
+      .kind = RecordKind::kFrame, .label = "frame", .event_ns = latest};
+  snapshot.at.fill(now);
+  ring_->push(snapshot);
+}
+
+bool Tracer::export_chrome_trace(const std::string& path) const {
+  std::vector<Snapshot> records = ring_->read();
+  std::ranges::sort(records, {}, [](const Snapshot& r) { return r.at[0]; });
+
+  int64_t origin = std::numeric_limits<int64_t>::max();
+  for (const auto& r : records) {
+    origin = std::min({origin, r.event_ns, r.at[0]});
+  }
+  const auto us = [origin](const int64_t ns) {
+    return static_cast<double>(ns - origin) / 1e3;
+  };
+
+  std::ofstream out(path);
+  if (!out) return false;
+  out << R"({"displayTimeUnit":"ns","traceEvents":[)";
+  constexpr std::array<const char*, 3> kThreads = {"exchange", "io", "ui"};
+  for (size_t tid = 0; tid < kThreads.size(); ++tid) {
+    out << std::format(
+        R"({}{{"name":"thread_name","ph":"M","pid":1,"tid":{},)"
+        R"("args":{{"name":"{}"}}}})",
+        tid == 0 ? "" : ",", tid, kThreads[tid]);
+  }
+  const auto span = [&](const std::string_view name, const int tid,
+                        const int64_t from, const int64_t to) {
+    out << std::format(
+        R"(,{{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},)"
+        R"("dur":{:.3f}}})",
+        name, tid, us(from), std::max(0.0, us(to) - us(from)));
+  };
+  for (const auto& r : records) {
+    if (r.kind == RecordKind::kFrame) {
+      const int64_t at = r.at[0];
+      out << std::format(
+          R"(,{{"name":"present","ph":"i","s":"t","pid":1,"tid":2,)"
+          R"("ts":{:.3f},"args":{{"age_us":{:.3f}}}}})",
+          us(at), static_cast<double>(at - r.event_ns) / 1e3);
+      continue;
+    }
+    span(std::format("network {}", r.label), 0, r.event_ns, r.at[0]);
+    for (size_t i = 1; i < kTimedStages; ++i) {
+      span(kStageNames[i], 1, r.at[i - 1], r.at[i]);
+    }
+  }
+  out << "]}\n";
+  return static_cast<bool>(out);
+}
+
+Tracer& tracer() noexcept {
+  static Tracer instance;
+  return instance;
+}
+}  // namespace telemetry
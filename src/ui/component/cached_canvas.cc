@@ -0,0 +1,57 @@
+module;
+#include <functional>
+#include <memory>
+
+#include "ftxui/dom/canvas.hpp"
+#include "ftxui/dom/elements.hpp"
+#include "ftxui/dom/node.hpp"
+#include "ftxui/screen/screen.hpp"
+
+module ui.component;
+
+namespace component {
+// Same layout and output as `ftxui::canvas(fn)`, but the drawing comes from
+// the owner's cache.
+class CachedCanvas::Node final : public ftxui::Node {
+ public:
+  explicit Node(CachedCanvas& owner) : owner_(owner) {}
+
+  void ComputeRequirement() override {
+    requirement_.min_x = 0;
+    requirement_.min_y = 0;
+  }
+
+  void Render(ftxui::Screen& screen) override {
+    const int columns = box_.x_max - box_.x_min + 1;
+    const int rows = box_.y_max - box_.y_min + 1;
+    if (columns <= 0 || rows <= 0) return;
+    // A terminal cell holds 2x4 braille dots.
+    const ftxui::Canvas& canvas = owner_.Update(columns * 2, rows * 4);
+    for (int y = 0; y < rows; ++y) {
+      for (int x = 0; x < columns; ++x) {
+        screen.PixelAt(box_.x_min + x, box_.y_min + y) = canvas.GetPixel(x, y);
+      }
+    }
+  }
+
+ private:
+  CachedCanvas& owner_;
+};
+
+CachedCanvas::CachedCanvas(DrawFunction draw) : draw_(std::move(draw)) {}
+
+ftxui::Element CachedCanvas::Render() {
+  return std::make_shared<Node>(*this) | ftxui::flex;
+}
+
+const ftxui::Canvas& CachedCanvas::Update(const int width, const int height) {
+  if (valid_ && !IsDirty(dirty_bit_) && canvas_.width() == width &&
+      canvas_.height() == height) {
+    return canvas_;
+  }
+  canvas_ = ftxui::Canvas(width, height);
+  draw_(canvas_);
+  valid_ = true;
+  return canvas_;
+}
+}  // namespace component
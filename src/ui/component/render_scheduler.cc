@@ -0,0 +1,83 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+module ui.component;
+
+namespace component {
+namespace {
+std::atomic<unsigned> g_next_dirty_bit{0};
+DirtyMask g_frame_dirty = kAllDirty;  // UI thread only
+}  // namespace
+
+DirtyMask RegisterDirtyBit() noexcept {
+  const unsigned bit =
+      std::min(g_next_dirty_bit.fetch_add(1, std::memory_order_relaxed), 63u);
+  return DirtyMask{1} << bit;
+}
+
+void BeginFrame(const DirtyMask dirty) noexcept { g_frame_dirty = dirty; }
+
+bool IsDirty(const DirtyMask bit) noexcept {
+  return (g_frame_dirty & bit) != 0;
+}
+
+RenderScheduler::RenderScheduler(const std::chrono::nanoseconds frame_interval,
+                                 std::function<void()> post_frame)
+    : frame_interval_(frame_interval),
+      post_frame_(std::move(post_frame)),
+      thread_([this](const std::stop_token& stop) { Run(stop); }) {}
+
+RenderScheduler::~RenderScheduler() {
+  thread_.request_stop();
+  // Wake the scheduler thread up so it can observe the stop request.
+  pending_.store(true, std::memory_order_release);
+  pending_.notify_one();
+}
+
+void RenderScheduler::Request(const DirtyMask dirty) noexcept {
+  // Release: a component that sees its bit also sees the events published
+  // before the request.
+  dirty_.fetch_or(dirty, std::memory_order_release);
+  requests_.fetch_add(1, std::memory_order_relaxed);
+  // Only the first request of a frame needs to wake the scheduler up.
+  if (!pending_.exchange(true, std::memory_order_acq_rel)) {
+    pending_.notify_one();
+  }
+}
+
+DirtyMask RenderScheduler::TakeDirty() noexcept {
+  return dirty_.exchange(0, std::memory_order_acq_rel);
+}
+
+RenderSchedulerStats RenderScheduler::stats() const noexcept {
+  return {
+      .requests = requests_.load(std::memory_order_relaxed),
+      .frames = frames_.load(std::memory_order_relaxed),
+  };
+}
+
+void RenderScheduler::Run(const std::stop_token& stop) {
+  using clock = std::chrono::steady_clock;
+  auto next_frame = clock::now();
+  while (!stop.stop_requested()) {
+    // Sleep until something changes; idle periods cost no frames.
+    pending_.wait(false, std::memory_order_acquire);
+    if (stop.stop_requested()) break;
+
+    // Never post two frames within one interval. After an idle period the
+    // deadline is already in the past, so the first change is shown at once.
+    next_frame = std::max(next_frame, clock::now());
+    std::this_thread::sleep_until(next_frame);
+    next_frame += frame_interval_;
+
+    // Requests arriving from here on are merged into the following frame.
+    pending_.store(false, std::memory_order_release);
+    frames_.fetch_add(1, std::memory_order_relaxed);
+    post_frame_();
+  }
+}
+}  // namespace component
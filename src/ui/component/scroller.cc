@@ -72,4 +72,99 @@ class ScrollerBase : public ComponentBase {
 Component Scroller(Component child) {
   return Make<ScrollerBase>(std::move(child));
 }
+
+class VirtualScrollerBase : public ComponentBase {
+ public:
+  VirtualScrollerBase(std::shared_ptr<ITableBody> body,
+                      const int viewport_height, const bool stick_to_end)
+      : body_(std::move(body)),
+        viewport_height_(viewport_height),
+        at_end_(stick_to_end) {}
+
+ private:
+  // Rows rendered above and below the viewport.
+  static constexpr int kOverscan = 2;
+
+  Element Render() final {
+    const auto focused = Focused() ? focus : ftxui::select;
+    const auto style = Focused() ? inverted : nothing;
+
+    size_ = static_cast<int>(body_->RowCount());
+    if (at_end_) selected_ = size_ - 1;
+    selected_ = std::max(0, std::min(size_ - 1, selected_));
+
+    // Same placement as yframe: keep the selected row centered.
+    const int height = box_.y_max > box_.y_min ? box_.y_max - box_.y_min + 1
+                                               : viewport_height_;
+    const int top =
+        std::max(0, std::min(size_ - height, selected_ - (height - 1) / 2));
+    const int first = std::max(0, top - kOverscan);
+    const int last = std::min(size_, top + height + kOverscan);
+
+    Element rows = body_->RenderRows(first, last - first);
+    Element window = dbox({
+                         std::move(rows),
+                         vbox({
+                             text(L"") | size(HEIGHT, EQUAL, selected_ - first),
+                             text(L"") | style | focused,
+                         }),
+                     }) |
+                     yframe | yflex;
+    return hbox({std::move(window) | flex, ScrollIndicator(top, height)}) |
+           reflect(box_);
+  }
+
+  // vscroll_indicator only sees the rendered slice, so draw the thumb from
+  // the full row count instead.
+  [[nodiscard]] Element ScrollIndicator(const int top, const int height) const {
+    if (size_ <= height) return emptyElement();
+    const int thumb = std::max(1, height * height / size_);
+    const int start = std::min(height - thumb, top * height / size_);
+    Elements cells;
+    cells.reserve(height);
+    for (int y = 0; y < height; ++y) {
+      const bool on_thumb = y >= start && y < start + thumb;
+      cells.push_back(text(on_thumb ? L"┃" : L" "));
+    }
+    return vbox(std::move(cells));
+  }
+
+  bool OnEvent(Event event) final {
+    if (event.is_mouse() && box_.Contain(event.mouse().x, event.mouse().y))
+      TakeFocus();
+
+    int selected_old = selected_;
+    if (event == Event::ArrowUp || event == Event::Character('k') ||
+        (event.is_mouse() && event.mouse().button == Mouse::WheelUp)) {
+      selected_--;
+    }
+    if ((event == Event::ArrowDown || event == Event::Character('j') ||
+         (event.is_mouse() && event.mouse().button == Mouse::WheelDown))) {
+      selected_++;
+    }
+    if (event == Event::PageDown) selected_ += box_.y_max - box_.y_min;
+    if (event == Event::PageUp) selected_ -= box_.y_max - box_.y_min;
+    if (event == Event::Home) selected_ = 0;
+    if (event == Event::End) selected_ = size_;
+
+    selected_ = std::max(0, std::min(size_ - 1, selected_));
+    if (selected_old != selected_) at_end_ = selected_ == size_ - 1;
+    return selected_old != selected_;
+  }
+
+  [[nodiscard]] bool Focusable() const final { return true; }
+
+  std::shared_ptr<ITableBody> body_;
+  const int viewport_height_;
+  bool at_end_;  // the selection follows the last row
+  int selected_ = 0;
+  int size_ = 0;
+  Box box_;
+};
+
+Component VirtualScroller(std::shared_ptr<ITableBody> body,
+                          const int viewport_height, const bool stick_to_end) {
+  return Make<VirtualScrollerBase>(std::move(body), viewport_height,
+                                   stick_to_end);
+}
 }  // namespace component
@@ -1,7 +1,8 @@
 module;
 #include "ftxui/dom/table.hpp"
 
-#include <mutex>
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -10,6 +11,8 @@ module;
 
 module ui.component;
 
+import telemetry;
+
 namespace component {
 using namespace ftxui;
 
@@ -21,14 +24,14 @@ TableHeader::TableHeader(
   header_row_ = {"Column1", "Column2", "Column3"};
   header_input.get_observable().subscribe([this](const HeaderType& new_header) {
     header_row_ = new_header;
-    header_update_subject_.get_observer().on_next(RedrawSignal{});
+    header_update_subject_.get_observer().on_next(RedrawSignal{dirty_bit_});
   });
 }
 
 void TableHeader::setColumnWidths(const std::vector<size_t>& new_widths) {
   if (new_widths == col_widths_) return;  // to avoid infinite cycle of redraws
   col_widths_ = new_widths;
-  header_update_subject_.get_observer().on_next(RedrawSignal{});
+  header_update_subject_.get_observer().on_next(RedrawSignal{dirty_bit_});
 }
 
 Element TableHeader::RenderCell(const std::string& cell, const size_t width,
@@ -48,35 +51,85 @@ Element TableHeader::Render() {
   return header_table.Render() | bgcolor(Color::Black);
 }
 
+void ColumnWidthTracker::Add(const std::vector<std::string>& row) {
+  if (counts_.size() < row.size()) {
+    counts_.resize(row.size());
+    widths_.resize(row.size(), 0);
+  }
+  for (size_t i = 0; i < row.size(); ++i) {
+    const size_t width = row[i].size();
+    if (counts_[i].size() <= width) counts_[i].resize(width + 1, 0);
+    ++counts_[i][width];
+    widths_[i] = std::max(widths_[i], width);
+  }
+}
+
+void ColumnWidthTracker::Remove(const std::vector<std::string>& row) {
+  for (size_t i = 0; i < row.size() && i < counts_.size(); ++i) {
+    const size_t width = row[i].size();
+    if (width >= counts_[i].size() || counts_[i][width] == 0) continue;
+    --counts_[i][width];
+    // Only removing the last cell of the widest width shrinks the column.
+    while (widths_[i] > 0 && counts_[i][widths_[i]] == 0) --widths_[i];
+  }
+}
+
+void ColumnWidthTracker::Clear() {
+  counts_.clear();
+  widths_.clear();
+}
+
 ScrollableTable::ScrollableTable(
     std::shared_ptr<TableHeader> header, std::shared_ptr<ITableBody> body,
     rpp::subjects::publish_subject<RedrawSignal>& redraw_subject)
     : header_component_(std::move(header)),
       body_component_(std::move(body)),
       redraw_subject_(redraw_subject) {
-  // Create and store persistent renderer and scroller.
-  body_renderer_ = Renderer([this] { return body_component_->Render(); });
-  body_scroller_ = Scroller(body_renderer_);
+  // Create and store a persistent scroller.
+  body_scroller_ = VirtualScroller(body_component_, kVisibleRows);
   Add(body_scroller_);
 }
 
+TableMetrics& table_metrics() {
+  static TableMetrics metrics{
+      .events = telemetry::metrics().counter(
+          "table_events_total", "Events applied to table bodies"),
+      .dropped = telemetry::metrics().counter(
+          "table_events_dropped_total",
+          "Events dropped because a table body's bus was full"),
+      .render = telemetry::metrics().histogram(
+          "table_render_seconds", "ScrollableTable render time"),
+  };
+  return metrics;
+}
+
+telemetry::Gauge& next_table_depth_gauge() {
+  static std::atomic<int> next{0};
+  return telemetry::metrics().gauge(
+      "table_queue_depth", "Events waiting for a table body at its last sync",
+      R"(table=")" + std::to_string(next++) + R"(")");
+}
+
 Element ScrollableTable::Render() {
+  const int64_t start = telemetry::monotonic_ns();
+  body_component_->Sync();
   recalcColumnWidths();
-  return vbox({header_component_->Render(),
-               body_scroller_->Render() | size(HEIGHT, EQUAL, 10)});
+  auto element =
+      vbox({header_component_->Render(),
+            body_scroller_->Render() | size(HEIGHT, EQUAL, kVisibleRows)});
+  table_metrics().render.record(telemetry::monotonic_ns() - start);
+  return element;
 }
 
 void ScrollableTable::recalcColumnWidths() const {
-  const auto header_row = header_component_->getHeaderRow();
-  std::vector<std::vector<std::string>> all_rows;
-  all_rows.push_back(header_row);
-  auto body_rows = body_component_->getRows();
-  all_rows.insert(all_rows.end(), body_rows.begin(), body_rows.end());
+  const auto& header_row = header_component_->getHeaderRow();
+  const auto& body_widths = body_component_->getContentWidths();
 
   std::vector<size_t> new_widths(header_row.size(), 0);
-  for (const auto& row : all_rows) {
-    for (size_t i = 0; i < row.size(); ++i) {
-      new_widths[i] = std::max(new_widths[i], row[i].size());
+  for (size_t i = 0; i < new_widths.size(); ++i) {
+    new_widths[i] = header_row[i].size();
+    if (i < body_widths.size()) {
+      new_widths[i] = std::max(new_widths[i], body_widths[i]);
     }
   }
   for (auto& width : new_widths) width += 2;
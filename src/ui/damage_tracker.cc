@@ -0,0 +1,131 @@
+module;
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ftxui/screen/screen.hpp"
+
+module ui;
+
+namespace ui {
+namespace {
+bool SameStyle(const ftxui::Pixel& a, const ftxui::Pixel& b) {
+  return a.bold == b.bold && a.dim == b.dim && a.italic == b.italic &&
+         a.inverted == b.inverted && a.underlined == b.underlined &&
+         a.underlined_double == b.underlined_double &&
+         a.strikethrough == b.strikethrough && a.blink == b.blink &&
+         a.foreground_color == b.foreground_color &&
+         a.background_color == b.background_color;
+}
+
+bool SamePixel(const ftxui::Pixel& a, const ftxui::Pixel& b) {
+  return a.character == b.character && SameStyle(a, b);
+}
+
+// True if turning `from` into `to` requires switching an attribute off,
+// which SGR can only do reliably with a full reset.
+bool NeedsReset(const ftxui::Pixel& from, const ftxui::Pixel& to) {
+  return (from.bold && !to.bold) || (from.dim && !to.dim) ||
+         (from.italic && !to.italic) || (from.inverted && !to.inverted) ||
+         (from.underlined && !to.underlined) ||
+         (from.underlined_double && !to.underlined_double) ||
+         (from.strikethrough && !to.strikethrough) ||
+         (from.blink && !to.blink);
+}
+}  // namespace
+
+void DamageTracker::MoveCursor(const int x, const int y) {
+  if (cursor_y_ == y && cursor_x_ == x) return;
+  const std::string absolute = std::format("\x1b[{};{}H", y + 1, x + 1);
+  if (cursor_y_ == y && cursor_x_ >= 0 && cursor_x_ < x) {
+    const std::string forward = std::format("\x1b[{}C", x - cursor_x_);
+    out_ += forward.size() < absolute.size() ? forward : absolute;
+  } else {
+    out_ += absolute;
+  }
+  cursor_x_ = x;
+  cursor_y_ = y;
+}
+
+void DamageTracker::ApplyStyle(const ftxui::Pixel& pixel) {
+  if (SameStyle(style_, pixel)) return;
+  std::string params;
+  const auto add = [&params](const std::string_view param) {
+    if (!params.empty()) params += ';';
+    params += param;
+  };
+  if (NeedsReset(style_, pixel)) {
+    add("0");
+    style_ = ftxui::Pixel{};
+  }
+  if (pixel.bold && !style_.bold) add("1");
+  if (pixel.dim && !style_.dim) add("2");
+  if (pixel.italic && !style_.italic) add("3");
+  if (pixel.underlined && !style_.underlined) add("4");
+  if (pixel.blink && !style_.blink) add("5");
+  if (pixel.inverted && !style_.inverted) add("7");
+  if (pixel.strikethrough && !style_.strikethrough) add("9");
+  if (pixel.underlined_double && !style_.underlined_double) add("21");
+  if (pixel.foreground_color != style_.foreground_color) {
+    add(pixel.foreground_color.Print(false));
+  }
+  if (pixel.background_color != style_.background_color) {
+    add(pixel.background_color.Print(true));
+  }
+  out_ += "\x1b[";
+  out_ += params;
+  out_ += 'm';
+  style_ = pixel;
+}
+
+std::string_view DamageTracker::Diff(ftxui::Screen& screen) {
+  out_.clear();
+  const int dimx = screen.dimx();
+  const int dimy = screen.dimy();
+  const bool full = previous_.empty() || dimx != dimx_ || dimy != dimy_;
+  if (full) {
+    out_ += "\x1b[0m\x1b[2J";
+    style_ = ftxui::Pixel{};
+    cursor_x_ = cursor_y_ = -1;
+    previous_.assign(static_cast<size_t>(dimx) * dimy, ftxui::Pixel{});
+    dimx_ = dimx;
+    dimy_ = dimy;
+    ++stats_.full_redraws;
+  }
+
+  uint64_t cells = 0;
+  for (int y = 0; y < dimy; ++y) {
+    for (int x = 0; x < dimx; ++x) {
+      const ftxui::Pixel& pixel = screen.PixelAt(x, y);
+      ftxui::Pixel& previous = previous_[static_cast<size_t>(y) * dimx + x];
+      if (!full && SamePixel(pixel, previous)) continue;
+      previous = pixel;
+      // The right half of a wide character is an empty cell; it is painted
+      // together with its left half.
+      if (pixel.character.empty()) continue;
+
+      MoveCursor(x, y);
+      ApplyStyle(pixel);
+      out_ += pixel.character;
+      ++cells;
+
+      const bool wide =
+          x + 1 < dimx && screen.PixelAt(x + 1, y).character.empty();
+      cursor_x_ = x + (wide ? 2 : 1);
+      // Writing the last column leaves the cursor in a pending-wrap state.
+      if (cursor_x_ >= dimx) cursor_x_ = -1;
+    }
+  }
+  if (!SameStyle(style_, ftxui::Pixel{})) {
+    out_ += "\x1b[0m";
+    style_ = ftxui::Pixel{};
+  }
+
+  ++stats_.frames;
+  stats_.bytes += out_.size();
+  stats_.last_frame_bytes = out_.size();
+  stats_.last_frame_cells = cells;
+  return out_;
+}
+}  // namespace ui
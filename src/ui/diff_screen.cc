@@ -0,0 +1,231 @@
+module;
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "ftxui/component/component_base.hpp"
+#include "ftxui/component/event.hpp"
+#include "ftxui/dom/node.hpp"
+#include "ftxui/screen/screen.hpp"
+
+module ui;
+
+import telemetry;
+
+namespace ui {
+namespace {
+// Decode one chunk read from the terminal into events.
+template <typename Sink>
+void ParseInput(const std::string_view input, Sink&& sink) {
+  using ftxui::Event;
+  if (input == "\x1b") {
+    sink(Event::Escape);
+    return;
+  }
+  static const std::pair<std::string_view, const Event*> kSequences[] = {
+      {"\x1b[A", &Event::ArrowUp},     {"\x1b[B", &Event::ArrowDown},
+      {"\x1b[C", &Event::ArrowRight},  {"\x1b[D", &Event::ArrowLeft},
+      {"\x1bOA", &Event::ArrowUp},     {"\x1bOB", &Event::ArrowDown},
+      {"\x1bOC", &Event::ArrowRight},  {"\x1bOD", &Event::ArrowLeft},
+      {"\x1b[H", &Event::Home},        {"\x1b[F", &Event::End},
+      {"\x1b[1~", &Event::Home},       {"\x1b[4~", &Event::End},
+      {"\x1b[5~", &Event::PageUp},     {"\x1b[6~", &Event::PageDown},
+  };
+  size_t pos = 0;
+  while (pos < input.size()) {
+    const std::string_view rest = input.substr(pos);
+    bool matched = false;
+    for (const auto& [sequence, event] : kSequences) {
+      if (rest.starts_with(sequence)) {
+        sink(*event);
+        pos += sequence.size();
+        matched = true;
+        break;
+      }
+    }
+    if (matched) continue;
+    const char c = rest.front();
+    if (c == '\x1b') {
+      // Unrecognized sequence: skip it. A lone ESC followed by other input
+      // is reported as Escape.
+      size_t end = 1;
+      if (rest.size() > 1 && rest[1] == '[') {
+        end = 2;
+        while (end < rest.size() && !(rest[end] >= '@' && rest[end] <= '~')) {
+          ++end;
+        }
+        ++end;  // final byte
+      } else if (rest.size() > 1 && rest[1] == 'O') {
+        end = 3;
+      } else {
+        sink(Event::Escape);
+      }
+      pos += std::min(end, rest.size());
+    } else if (c == '\r' || c == '\n') {
+      sink(Event::Return);
+      ++pos;
+    } else if (c == '\x7f') {
+      sink(Event::Backspace);
+      ++pos;
+    } else if (c == '\t') {
+      sink(Event::Tab);
+      ++pos;
+    } else {
+      // One UTF-8 encoded character.
+      size_t length = 1;
+      while (pos + length < input.size() &&
+             (static_cast<unsigned char>(input[pos + length]) & 0xC0) == 0x80) {
+        ++length;
+      }
+      sink(Event::Character(std::string(input.substr(pos, length))));
+      pos += length;
+    }
+  }
+}
+
+// Puts the terminal in raw mode on the alternate screen for its lifetime.
+class RawTerminal {
+ public:
+  RawTerminal(const int input_fd, const int output_fd)
+      : input_fd_(input_fd), output_fd_(output_fd) {
+    saved_valid_ = tcgetattr(input_fd_, &saved_) == 0;
+    if (saved_valid_) {
+      termios raw = saved_;
+      // Without ISIG, Ctrl+C arrives as input and exits the loop, so the
+      // terminal is restored instead of left raw by SIGINT.
+      raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+      raw.c_iflag &= ~(IXON | ICRNL);
+      raw.c_cc[VMIN] = 0;
+      raw.c_cc[VTIME] = 0;
+      tcsetattr(input_fd_, TCSANOW, &raw);
+    }
+    // Alternate screen, hidden cursor.
+    constexpr std::string_view enter = "\x1b[?1049h\x1b[?25l";
+    [[maybe_unused]] auto _ = ::write(output_fd_, enter.data(), enter.size());
+  }
+
+  ~RawTerminal() {
+    constexpr std::string_view leave = "\x1b[0m\x1b[?25h\x1b[?1049l";
+    [[maybe_unused]] auto _ = ::write(output_fd_, leave.data(), leave.size());
+    if (saved_valid_) tcsetattr(input_fd_, TCSANOW, &saved_);
+  }
+
+  RawTerminal(const RawTerminal&) = delete;
+  RawTerminal& operator=(const RawTerminal&) = delete;
+
+ private:
+  const int input_fd_;
+  const int output_fd_;
+  termios saved_{};
+  bool saved_valid_ = false;
+};
+}  // namespace
+
+DiffScreen::DiffScreen(const int output_fd, const int input_fd)
+    : output_fd_(output_fd), input_fd_(input_fd) {}
+
+void DiffScreen::PostEvent(const ftxui::Event& event) {
+  {
+    std::lock_guard lock(mutex_);
+    events_.push_back(event);
+  }
+  events_cv_.notify_one();
+}
+
+void DiffScreen::Exit() {
+  {
+    std::lock_guard lock(mutex_);
+    quit_ = true;
+  }
+  events_cv_.notify_one();
+}
+
+OutputStats DiffScreen::stats() const {
+  std::lock_guard lock(mutex_);
+  return tracker_.stats();
+}
+
+bool DiffScreen::Write(std::string_view bytes) const {
+  while (!bytes.empty()) {
+    const ssize_t written = ::write(output_fd_, bytes.data(), bytes.size());
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) return false;
+    bytes.remove_prefix(static_cast<size_t>(written));
+  }
+  return true;
+}
+
+void DiffScreen::ReadInput() {
+  char buffer[256];
+  pollfd fd{.fd = input_fd_, .events = POLLIN, .revents = 0};
+  while (!quit_) {
+    if (::poll(&fd, 1, 50) <= 0) continue;
+    const ssize_t size = ::read(input_fd_, buffer, sizeof(buffer));
+    if (size <= 0) continue;
+    const std::string_view input(buffer, static_cast<size_t>(size));
+    if (input.find('\x03') != std::string_view::npos) {  // Ctrl+C
+      Exit();
+      return;
+    }
+    ParseInput(input, [this](const ftxui::Event& event) { PostEvent(event); });
+  }
+}
+
+void DiffScreen::Draw(const ftxui::Component& component) {
+  winsize size{};
+  int width = 80, height = 24;
+  if (::ioctl(output_fd_, TIOCGWINSZ, &size) == 0 && size.ws_col > 0) {
+    width = size.ws_col;
+    height = size.ws_row;
+  }
+  auto screen = ftxui::Screen::Create(ftxui::Dimension::Fixed(width),
+                                      ftxui::Dimension::Fixed(height));
+  ftxui::Render(screen, component->Render());
+
+  std::string_view bytes;
+  {
+    std::lock_guard lock(mutex_);
+    bytes = tracker_.Diff(screen);
+  }
+  // Written unlocked: on a slow link the write blocks, and PostEvent must
+  // not wait for it. Only this thread calls Diff, so the view stays valid.
+  if (!Write(bytes)) {
+    // The terminal holds part of a frame: repaint all of the next one.
+    std::lock_guard lock(mutex_);
+    tracker_.Invalidate();
+  }
+  telemetry::tracer().frame_presented();
+}
+
+void DiffScreen::Loop(const ftxui::Component& component) {
+  quit_ = false;
+  RawTerminal terminal(input_fd_, output_fd_);
+  tracker_.Invalidate();
+  std::jthread input_thread([this] { ReadInput(); });
+
+  Draw(component);
+  while (!quit_) {
+    std::deque<ftxui::Event> events;
+    {
+      std::unique_lock lock(mutex_);
+      events_cv_.wait(lock, [this] { return quit_ || !events_.empty(); });
+      events.swap(events_);
+    }
+    for (const auto& event : events) {
+      if (quit_) break;
+      component->OnEvent(event);
+    }
+    if (!quit_) Draw(component);
+  }
+}
+}  // namespace ui
@@ -0,0 +1,253 @@
+module;
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <format>
+#include <limits>
+#include <vector>
+
+#include "ftxui/component/component.hpp"
+#include "ftxui/component/event.hpp"
+#include "ftxui/dom/canvas.hpp"
+#include "rpp/subjects/publish_subject.hpp"
+
+module ui.widget;
+
+import state;
+import ui.component;
+
+namespace widget {
+namespace {
+struct Candle {
+  int64_t index;  // start time in base intervals since epoch
+  double open;
+  double high;
+  double low;
+  double close;
+  double volume;
+  double buy_volume;
+
+  void Merge(const Candle& later) {
+    high = std::max(high, later.high);
+    low = std::min(low, later.low);
+    close = later.close;
+    volume += later.volume;
+    buy_volume += later.buy_volume;
+  }
+};
+
+// Candle history pre-aggregated into levels: a level-k candle spans
+// kFanout^k base intervals. Every level keeps the same time horizon, so the
+// whole pyramid costs about 4/3 of the base level. A view with N columns is
+// served from the coarsest level that still has at least one candle per
+// column, touching O(N) candles whatever the history length.
+class CandlePyramid {
+ public:
+  static constexpr int kFanoutBits = 2;  // fan-out of 4
+  static constexpr int kLevels = 8;
+
+  explicit CandlePyramid(const size_t history) {
+    for (int level = 0; level < kLevels; ++level) {
+      capacity_[level] = std::max<size_t>(history >> (kFanoutBits * level), 2);
+    }
+  }
+
+  void Add(const int64_t index, const double price, const double quantity,
+           const bool is_buy) {
+    const Candle tick{index,    price, price, price, price, quantity,
+                      is_buy ? quantity : 0.0};
+    for (int level = 0; level < kLevels; ++level) {
+      auto& candles = levels_[level];
+      Candle candle = tick;
+      candle.index = index >> (kFanoutBits * level);
+      if (candles.empty() || candles.back().index < candle.index) {
+        candles.push_back(candle);
+        if (candles.size() > capacity_[level]) candles.pop_front();
+        continue;
+      }
+      // Late trade: merge into the candle it belongs to, if still retained.
+      const auto it = Find(level, candle.index);
+      if (it != candles.end() && it->index == candle.index) {
+        const double close = it->close;
+        it->Merge(candle);
+        it->close = close;  // a late trade does not move the close
+      }
+    }
+  }
+
+  [[nodiscard]] bool empty() const { return levels_[0].empty(); }
+
+  [[nodiscard]] int64_t LastIndex() const { return levels_[0].back().index; }
+
+  // Aggregate `columns` candles of 2^zoom base intervals each, the last one
+  // ending at base interval `end_index`. Columns without trades are absent.
+  [[nodiscard]] std::vector<std::pair<size_t, Candle>> Query(
+      const int64_t end_index, const size_t columns, const int zoom) const {
+    const int level = std::min(zoom / kFanoutBits, kLevels - 1);
+    const int level_shift = kFanoutBits * level;
+    const int column_shift = zoom;
+    const int64_t last_column = end_index >> column_shift;
+    const int64_t first_column =
+        last_column - static_cast<int64_t>(columns) + 1;
+
+    std::vector<std::pair<size_t, Candle>> result;
+    result.reserve(columns);
+    const auto& candles = levels_[level];
+    for (auto it = Find(level, (first_column << column_shift) >> level_shift);
+         it != candles.end(); ++it) {
+      const int64_t column = (it->index << level_shift) >> column_shift;
+      if (column > last_column) break;
+      const auto slot = static_cast<size_t>(column - first_column);
+      if (!result.empty() && result.back().first == slot) {
+        result.back().second.Merge(*it);
+      } else {
+        result.emplace_back(slot, *it);
+      }
+    }
+    return result;
+  }
+
+ private:
+  [[nodiscard]] std::deque<Candle>::const_iterator Find(
+      const int level, const int64_t index) const {
+    const auto& candles = levels_[level];
+    return std::ranges::lower_bound(candles, index, {}, &Candle::index);
+  }
+  [[nodiscard]] std::deque<Candle>::iterator Find(const int level,
+                                                  const int64_t index) {
+    auto& candles = levels_[level];
+    return std::ranges::lower_bound(candles, index, {}, &Candle::index);
+  }
+
+  std::array<std::deque<Candle>, kLevels> levels_{};
+  std::array<size_t, kLevels> capacity_{};
+};
+}  // namespace
+
+// Candlestick and volume chart over the aggregated trade stream. Arrow keys
+// pan, '+'/'-' zoom, End returns to the live edge.
+class CandleChart final : public ftxui::ComponentBase {
+ public:
+  CandleChart(const publish_subject<state::Trade>& trade_input,
+              publish_subject<component::RedrawSignal>& output)
+      : bus_(component::Delivery::kQueued), update_subject_(output) {
+    trade_input.get_observable().subscribe([this](const state::Trade& trade) {
+      bus_.publish(trade);
+      update_subject_.get_observer().on_next(
+          component::RedrawSignal{canvas_.dirty_bit()});
+    });
+  }
+
+  ftxui::Element Render() override {
+    if (!component::IsDirty(canvas_.dirty_bit())) return canvas_.Render();
+    bus_.drain([this](const state::Trade& trade) {
+      const auto since_epoch = trade.trade_time.time_since_epoch();
+      const int64_t index =
+          std::chrono::duration_cast<std::chrono::seconds>(since_epoch)
+              .count();
+      // The taker bought when the buyer is not the market maker.
+      pyramid_.Add(index, trade.price, trade.quantity,
+                   !trade.is_buyer_market_maker);
+    });
+    dropped_ = bus_.stats().dropped;
+    return canvas_.Render();
+  }
+
+  bool OnEvent(ftxui::Event event) override {
+    using ftxui::Event;
+    if (event == Event::Character('+')) {
+      zoom_ = std::max(zoom_ - 1, 0);
+    } else if (event == Event::Character('-')) {
+      zoom_ = std::min(zoom_ + 1, kMaxZoom);
+    } else if (event == Event::ArrowLeft) {
+      pan_ += 1;
+    } else if (event == Event::ArrowRight) {
+      pan_ = std::max(pan_ - 1, int64_t{0});
+    } else if (event == Event::End) {
+      pan_ = 0;
+    } else {
+      return false;
+    }
+    canvas_.Invalidate();
+    return true;
+  }
+
+  [[nodiscard]] bool Focusable() const override { return true; }
+
+ private:
+  static constexpr size_t kHistorySeconds = 1 << 17;  // ~36 hours
+  // Zoom z shows 2^z seconds per candle.
+  static constexpr int kMaxZoom =
+      CandlePyramid::kFanoutBits * CandlePyramid::kLevels - 1;
+  // Each candle takes one terminal cell (2x4 canvas dots).
+  static constexpr int kDotsPerCandle = 2;
+
+  void Draw(ftxui::Canvas& c) {
+    if (pyramid_.empty()) {
+      c.DrawText(0, 0, "Waiting for trades...");
+      return;
+    }
+
+    const size_t columns = std::max(c.width() / kDotsPerCandle, 1);
+    const int64_t end_index = pyramid_.LastIndex() - (pan_ << zoom_);
+    const auto candles = pyramid_.Query(end_index, columns, zoom_);
+    if (candles.empty()) {
+      c.DrawText(0, 0, "No trades in range");
+      return;
+    }
+
+    // Bottom fifth of the canvas is the volume histogram.
+    const int price_height = c.height() * 4 / 5;
+    const int volume_height = c.height() - price_height;
+    double low = std::numeric_limits<double>::max();
+    double high = std::numeric_limits<double>::lowest();
+    double max_volume = 0.0;
+    for (const auto& [slot, candle] : candles) {
+      low = std::min(low, candle.low);
+      high = std::max(high, candle.high);
+      max_volume = std::max(max_volume, candle.volume);
+    }
+    const double span = std::max(high - low, 1e-9);
+    const auto price_y = [&](const double price) {
+      return static_cast<int>(
+          std::lround((high - price) / span * (price_height - 1)));
+    };
+
+    for (const auto& [slot, candle] : candles) {
+      const int x = static_cast<int>(slot) * kDotsPerCandle;
+      const bool up = candle.close >= candle.open;
+      const ftxui::Color color = up ? ftxui::Color::Green : ftxui::Color::Red;
+      c.DrawPointLine(x, price_y(candle.high), x, price_y(candle.low), color);
+      c.DrawBlockLine(x, price_y(candle.open), x, price_y(candle.close), color);
+
+      const int bar = static_cast<int>(
+          std::lround(candle.volume / max_volume * (volume_height - 1)));
+      c.DrawPointLine(x, c.height() - 1, x, c.height() - 1 - bar, color);
+    }
+
+    c.DrawText(0, 0, std::format("{:.2f}", high));
+    c.DrawText(0, std::max(0, (price_height / 4 - 1) * 4),
+               std::format("{:.2f}", low));
+    c.DrawText(c.width() / 2, 0, std::format("{}s/candle", int64_t{1} << zoom_));
+    if (dropped_ != 0) {
+      c.DrawText(c.width() / 2, 4, std::format("{} trades dropped", dropped_),
+                 ftxui::Color::Yellow);
+    }
+  }
+
+  component::EventBus<state::Trade> bus_;
+  publish_subject<component::RedrawSignal>& update_subject_;
+  component::CachedCanvas canvas_{[this](ftxui::Canvas& c) { Draw(c); }};
+  CandlePyramid pyramid_{kHistorySeconds};
+  uint64_t dropped_ = 0;  // trades missing from the candles
+  int zoom_ = 0;
+  int64_t pan_ = 0;  // candles scrolled back from the live edge
+};
+
+ftxui::Component Candles(const publish_subject<state::Trade>& trade_input,
+                         publish_subject<component::RedrawSignal>& output) {
+  return std::make_shared<CandleChart>(trade_input, output);
+}
+}  // namespace widget
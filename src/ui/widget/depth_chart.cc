@@ -0,0 +1,223 @@
+module;
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <functional>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "ftxui/component/component.hpp"
+#include "ftxui/dom/canvas.hpp"
+#include "rpp/subjects/publish_subject.hpp"
+
+module ui.widget;
+
+import state;
+import ui.component;
+
+namespace widget {
+// Cumulative bid/ask volume around the mid price.
+//
+// Levels are kept per side and bucketed into one bucket per canvas column of
+// the visible price range. Deltas adjust the affected bucket only; levels are
+// re-bucketed when the range has to move (mid drifted away or the canvas was
+// resized), so a frame costs O(columns) regardless of book depth.
+class DepthChartCanvas final : public ftxui::ComponentBase {
+ public:
+  DepthChartCanvas(const publish_subject<state::OrderBookDelta>& delta_input,
+                   std::function<void()> request_reset,
+                   publish_subject<component::RedrawSignal>& output)
+      : bus_(component::Delivery::kQueued, kDeltaQueueCapacity),
+        request_reset_(std::move(request_reset)),
+        update_subject_(output) {
+    delta_input.get_observable().subscribe(
+        [this](const state::OrderBookDelta& delta) {
+          bus_.publish(delta);
+          update_subject_.get_observer().on_next(
+              component::RedrawSignal{canvas_.dirty_bit()});
+        });
+  }
+
+  ftxui::Element Render() override {
+    if (component::IsDirty(canvas_.dirty_bit())) Sync();
+    return canvas_.Render();
+  }
+
+ private:
+  // Visible range is mid ± kRangeFraction of the mid price.
+  static constexpr double kRangeFraction = 0.005;
+  // Re-center once the mid moved this fraction of the range off center.
+  static constexpr double kRecenterFraction = 0.1;
+  static constexpr size_t kDeltaQueueCapacity = 1 << 14;
+
+  struct Side {
+    std::map<double, double> levels;  // price -> quantity
+    std::vector<double> buckets;      // quantity per column of the range
+    std::vector<int> curve;           // y per column, -1 where not drawn
+  };
+
+  void Sync() {
+    bus_.drain(
+        [this](const state::OrderBookDelta& delta) { ApplyDelta(delta); });
+    // Rebuild from a reset; a dropped reset is requested again.
+    if (const uint64_t dropped = bus_.stats().dropped;
+        dropped != dropped_seen_) {
+      dropped_seen_ = dropped;
+      stale_ = true;
+      request_reset_();
+    }
+  }
+
+  void ApplyDelta(const state::OrderBookDelta& delta) {
+    if (delta.reset) {
+      bids_.levels.clear();
+      asks_.levels.clear();
+      range_valid_ = false;
+      stale_ = false;
+    }
+    if (stale_) return;
+    for (const auto& entry : delta.bids) ApplyLevel(bids_, entry);
+    for (const auto& entry : delta.asks) ApplyLevel(asks_, entry);
+    curves_dirty_ = true;
+  }
+
+  void ApplyLevel(Side& side, const state::OrderBookEntry& entry) {
+    double previous = 0.0;
+    if (const auto it = side.levels.find(entry.price);
+        it != side.levels.end()) {
+      previous = it->second;
+      if (entry.quantity == 0.0) {
+        side.levels.erase(it);
+      } else {
+        it->second = entry.quantity;
+      }
+    } else if (entry.quantity != 0.0) {
+      side.levels.emplace(entry.price, entry.quantity);
+    }
+    if (!range_valid_) return;
+    if (const auto column = Column(entry.price)) {
+      side.buckets[*column] += entry.quantity - previous;
+    }
+  }
+
+  [[nodiscard]] std::optional<size_t> Column(const double price) const {
+    if (price < low_ || price >= high_) return std::nullopt;
+    const auto column = static_cast<size_t>((price - low_) / step_);
+    return std::min(column, columns_ - 1);
+  }
+
+  void Rebucket(const int columns, const double mid) {
+    columns_ = static_cast<size_t>(std::max(columns, 1));
+    center_ = mid;
+    low_ = mid * (1.0 - kRangeFraction);
+    high_ = mid * (1.0 + kRangeFraction);
+    step_ = (high_ - low_) / static_cast<double>(columns_);
+    range_valid_ = true;
+    for (Side* side : {&bids_, &asks_}) {
+      side->buckets.assign(columns_, 0.0);
+      for (auto it = side->levels.lower_bound(low_);
+           it != side->levels.end() && it->first < high_; ++it) {
+        side->buckets[*Column(it->first)] += it->second;
+      }
+    }
+    curves_dirty_ = true;
+  }
+
+  void RebuildCurves(const int height) {
+    height_ = height;
+    curves_dirty_ = false;
+
+    // Bids accumulate from the mid outwards, i.e. right to left; asks left to
+    // right.
+    std::vector<double> bid_total(columns_), ask_total(columns_);
+    double acc = 0.0;
+    for (size_t i = columns_; i-- > 0;) {
+      acc += std::max(bids_.buckets[i], 0.0);
+      bid_total[i] = acc;
+    }
+    acc = 0.0;
+    for (size_t i = 0; i < columns_; ++i) {
+      acc += std::max(asks_.buckets[i], 0.0);
+      ask_total[i] = acc;
+    }
+    const double max_total = std::max(bid_total.front(), ask_total.back());
+
+    const auto best_bid = Column(bids_.levels.rbegin()->first);
+    const auto best_ask = Column(asks_.levels.begin()->first);
+    const auto to_y = [&](const double total) {
+      if (max_total <= 0.0) return height - 1;
+      return height - 1 -
+             static_cast<int>(std::lround(total / max_total * (height - 1)));
+    };
+    bids_.curve.assign(columns_, -1);
+    asks_.curve.assign(columns_, -1);
+    for (size_t i = 0; i < columns_; ++i) {
+      if (best_bid && i <= *best_bid) bids_.curve[i] = to_y(bid_total[i]);
+      if (best_ask && i >= *best_ask) asks_.curve[i] = to_y(ask_total[i]);
+    }
+  }
+
+  void Draw(ftxui::Canvas& c) {
+    if (stale_ || bids_.levels.empty() || asks_.levels.empty()) {
+      c.DrawText(0, 0, "Waiting for order book...");
+      return;
+    }
+
+    const double mid =
+        (bids_.levels.rbegin()->first + asks_.levels.begin()->first) / 2.0;
+    if (!range_valid_ || static_cast<size_t>(c.width()) != columns_ ||
+        std::abs(mid - center_) > (high_ - low_) * kRecenterFraction) {
+      Rebucket(c.width(), mid);
+    }
+    if (curves_dirty_ || c.height() != height_) RebuildCurves(c.height());
+
+    const auto draw_curve = [&c](const std::vector<int>& curve,
+                                 const ftxui::Color& color) {
+      for (size_t x = 0; x < curve.size(); ++x) {
+        if (curve[x] < 0) continue;
+        c.DrawPointLine(static_cast<int>(x), curve[x], static_cast<int>(x),
+                        c.height() - 1, color);
+      }
+    };
+    draw_curve(bids_.curve, ftxui::Color::Green);
+    draw_curve(asks_.curve, ftxui::Color::Red);
+
+    // Price axis labels (text rows are 4 dots high).
+    const int label_y = std::max(0, (c.height() / 4 - 1) * 4);
+    c.DrawText(0, label_y, std::format("{:.2f}", low_));
+    c.DrawText(c.width() / 2, label_y, std::format("{:.2f}", mid));
+    const std::string high = std::format("{:.2f}", high_);
+    c.DrawText(std::max(0, c.width() - static_cast<int>(high.size()) * 2),
+               label_y, high);
+  }
+
+  component::EventBus<state::OrderBookDelta> bus_;
+  std::function<void()> request_reset_;
+  publish_subject<component::RedrawSignal>& update_subject_;
+  component::CachedCanvas canvas_{[this](ftxui::Canvas& c) { Draw(c); }};
+  uint64_t dropped_seen_ = 0;
+  bool stale_ = true;  // until the first snapshot arrives
+
+  Side bids_{};
+  Side asks_{};
+
+  bool range_valid_ = false;
+  bool curves_dirty_ = true;
+  size_t columns_ = 1;
+  int height_ = 0;
+  double center_ = 0.0;
+  double low_ = 0.0;
+  double high_ = 0.0;
+  double step_ = 1.0;
+};
+
+ftxui::Component DepthChart(
+    const publish_subject<state::OrderBookDelta>& delta_input,
+    std::function<void()> request_reset,
+    publish_subject<component::RedrawSignal>& output) {
+  return std::make_shared<DepthChartCanvas>(delta_input,
+                                            std::move(request_reset), output);
+}
+}  // namespace widget
@@ -0,0 +1,329 @@
+module;
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <vector>
+
+#include "ftxui/component/component.hpp"
+#include "ftxui/dom/canvas.hpp"
+#include "rpp/subjects/publish_subject.hpp"
+
+module ui.widget;
+
+import state;
+import ui.component;
+
+namespace widget {
+namespace {
+// Price buckets per column, centered on the mid price.
+constexpr int kRows = 256;
+// Resting size is stored as round(log2(1 + size) * kSizeScale), capped at 255.
+constexpr double kSizeScale = 32.0;
+
+struct HeatmapColumn {
+  int64_t time_ms = 0;
+  int64_t anchor = 0;  // bucket of the mid price; row i is anchor-kRows/2+i
+  std::array<uint8_t, kRows> levels{};
+};
+
+// Bucket the book around its mid price. Only the levels inside the column's
+// price range are visited.
+HeatmapColumn Quantize(const state::OrderBook& ob, const double tick,
+                       const int64_t time_ms) {
+  HeatmapColumn column{.time_ms = time_ms};
+  const double mid =
+      (ob.bids.rbegin()->first + ob.asks.begin()->first) / 2.0;
+  column.anchor = std::llround(mid / tick);
+  const int64_t first = column.anchor - kRows / 2;
+  const double low = (static_cast<double>(first) - 0.5) * tick;
+  const double high = (static_cast<double>(first + kRows) - 0.5) * tick;
+
+  std::array<double, kRows> sizes{};
+  for (const auto* side : {&ob.bids, &ob.asks}) {
+    for (auto it = side->lower_bound(low); it != side->end() && it->first < high;
+         ++it) {
+      const int64_t row = std::llround(it->first / tick) - first;
+      if (row >= 0 && row < kRows) sizes[row] += it->second.quantity;
+    }
+  }
+  for (int row = 0; row < kRows; ++row) {
+    column.levels[row] = static_cast<uint8_t>(
+        std::min(255.0, std::round(std::log2(1.0 + sizes[row]) * kSizeScale)));
+  }
+  return column;
+}
+
+uint64_t ZigZag(const int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(const uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void PutVarint(std::vector<uint8_t>& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+uint64_t GetVarint(const uint8_t*& in) {
+  uint64_t value = 0;
+  for (int shift = 0;; shift += 7) {
+    const uint8_t byte = *in++;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return value;
+  }
+}
+
+// Level of `row` of `column` as seen from a column anchored at `anchor`.
+uint8_t Shifted(const HeatmapColumn& column, const int64_t anchor,
+                const int row) {
+  const int64_t source = row + (anchor - column.anchor);
+  return source >= 0 && source < kRows ? column.levels[source] : 0;
+}
+
+// Append-only history of heatmap columns under a fixed memory budget.
+//
+// Columns are stored in groups of kKeyframeInterval. The first column of a
+// group is encoded against an empty column, the others against their
+// predecessor (re-aligned when the mid moved), as varint-coded runs of
+// changed rows. Once the budget is exceeded the oldest group is dropped
+// whole, so every retained group stays decodable on its own.
+class LiquidityHistory {
+ public:
+  explicit LiquidityHistory(const size_t budget_bytes)
+      : budget_bytes_(budget_bytes) {}
+
+  void Append(const HeatmapColumn& column) {
+    if (groups_.empty() || groups_.back().offsets.size() >= kKeyframeInterval) {
+      if (!groups_.empty()) {
+        auto& bytes = groups_.back().bytes;
+        bytes_ -= bytes.capacity();
+        bytes.shrink_to_fit();
+        bytes_ += bytes.capacity();
+      }
+      groups_.emplace_back();
+      previous_ = HeatmapColumn{};  // keyframe: encoded against nothing
+    }
+    Group& group = groups_.back();
+    const size_t before = group.bytes.capacity();
+    group.offsets.push_back(static_cast<uint32_t>(group.bytes.size()));
+    Encode(column, previous_, group.bytes);
+    bytes_ += group.bytes.capacity() - before + sizeof(uint32_t);
+    previous_ = column;
+    ++columns_;
+
+    while (bytes_ > budget_bytes_ && groups_.size() > 1) {
+      const Group& oldest = groups_.front();
+      bytes_ -= oldest.bytes.capacity() +
+                oldest.offsets.size() * sizeof(uint32_t);
+      columns_ -= oldest.offsets.size();
+      groups_.pop_front();
+    }
+  }
+
+  [[nodiscard]] size_t size() const { return columns_; }
+  [[nodiscard]] size_t bytes() const { return bytes_; }
+
+  // Decode the newest `count` columns, oldest first. Only the groups that
+  // overlap the window are touched.
+  void DecodeLast(size_t count, std::vector<HeatmapColumn>& out) const {
+    out.clear();
+    count = std::min(count, columns_);
+    size_t skip = columns_ - count;
+    auto group = groups_.begin();
+    while (group != groups_.end() && skip >= group->offsets.size()) {
+      skip -= group->offsets.size();
+      ++group;
+    }
+    for (; group != groups_.end(); ++group) {
+      const uint8_t* in = group->bytes.data();
+      HeatmapColumn column{};
+      for (size_t i = 0; i < group->offsets.size(); ++i) {
+        column = Decode(in, i == 0 ? HeatmapColumn{} : column);
+        if (skip > 0) {
+          --skip;
+        } else {
+          out.push_back(column);
+        }
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t kKeyframeInterval = 64;
+
+  struct Group {
+    std::vector<uint8_t> bytes;
+    std::vector<uint32_t> offsets;
+  };
+
+  static void Encode(const HeatmapColumn& column, const HeatmapColumn& previous,
+                     std::vector<uint8_t>& out) {
+    PutVarint(out, ZigZag(column.time_ms - previous.time_ms));
+    PutVarint(out, ZigZag(column.anchor - previous.anchor));
+    std::array<std::pair<uint8_t, int16_t>, kRows> changes;
+    size_t count = 0;
+    int last_row = 0;
+    for (int row = 0; row < kRows; ++row) {
+      const int delta =
+          column.levels[row] - Shifted(previous, column.anchor, row);
+      if (delta == 0) continue;
+      changes[count++] = {static_cast<uint8_t>(row - last_row),
+                          static_cast<int16_t>(delta)};
+      last_row = row;
+    }
+    PutVarint(out, count);
+    for (size_t i = 0; i < count; ++i) {
+      PutVarint(out, changes[i].first);
+      PutVarint(out, ZigZag(changes[i].second));
+    }
+  }
+
+  static HeatmapColumn Decode(const uint8_t*& in,
+                              const HeatmapColumn& previous) {
+    HeatmapColumn column{};
+    column.time_ms = previous.time_ms + UnZigZag(GetVarint(in));
+    column.anchor = previous.anchor + UnZigZag(GetVarint(in));
+    for (int row = 0; row < kRows; ++row) {
+      column.levels[row] = Shifted(previous, column.anchor, row);
+    }
+    const uint64_t count = GetVarint(in);
+    int row = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+      row += static_cast<int>(GetVarint(in));
+      column.levels[row] = static_cast<uint8_t>(column.levels[row] +
+                                                UnZigZag(GetVarint(in)));
+    }
+    return column;
+  }
+
+  const size_t budget_bytes_;
+  std::deque<Group> groups_;
+  HeatmapColumn previous_{};
+  size_t bytes_ = 0;
+  size_t columns_ = 0;
+};
+}  // namespace
+
+// Order book heatmap: price on the vertical axis, time on the horizontal one,
+// colored by resting size.
+class LiquidityHeatmap final : public ftxui::ComponentBase {
+ public:
+  LiquidityHeatmap(const publish_subject<state::OrderBook>& order_book_input,
+                   publish_subject<component::RedrawSignal>& output,
+                   const size_t budget_bytes)
+      : bus_(component::Delivery::kQueued, 1024),
+        update_subject_(output),
+        history_(budget_bytes) {
+    // Quantize on the io thread; only the compact column crosses threads.
+    order_book_input.get_observable().subscribe(
+        [this](const state::OrderBook& ob) {
+          if (ob.bids.empty() || ob.asks.empty()) return;
+          if (tick_ == 0.0) {
+            // Fix the bucket size on the first book: about 1bp of the price,
+            // rounded down to a power of ten.
+            const double mid =
+                (ob.bids.rbegin()->first + ob.asks.begin()->first) / 2.0;
+            tick_ = std::pow(10.0, std::floor(std::log10(mid * 1e-4)));
+          }
+          const auto now = std::chrono::system_clock::now();
+          const int64_t time_ms =
+              std::chrono::duration_cast<std::chrono::milliseconds>(
+                  now.time_since_epoch())
+                  .count();
+          bus_.publish(Quantize(ob, tick_, time_ms));
+          update_subject_.get_observer().on_next(
+              component::RedrawSignal{canvas_.dirty_bit()});
+        });
+  }
+
+  ftxui::Element Render() override {
+    if (component::IsDirty(canvas_.dirty_bit()) &&
+        bus_.drain([this](const HeatmapColumn& column) {
+          history_.Append(column);
+        }) > 0) {
+      window_dirty_ = true;
+    }
+    dropped_ = bus_.stats().dropped;
+    return canvas_.Render();
+  }
+
+ private:
+  void Draw(ftxui::Canvas& c) {
+    // One column per terminal cell (2 dots wide), one row per 2 dots.
+    const size_t columns = static_cast<size_t>(std::max(c.width() / 2, 1));
+    if (window_dirty_ || columns != window_.size()) {
+      history_.DecodeLast(columns, window_);
+      window_dirty_ = false;
+    }
+    if (window_.empty()) {
+      c.DrawText(0, 0, "Waiting for order book...");
+      return;
+    }
+
+    // Rows are aligned on the newest mid price.
+    const int64_t anchor = window_.back().anchor;
+    const int rows = std::min(c.height() / 2, kRows);
+    const int64_t top_bucket = anchor + rows / 2;
+    for (size_t x = 0; x < window_.size(); ++x) {
+      const HeatmapColumn& column = window_[x];
+      for (int y = 0; y < rows; ++y) {
+        const int64_t row = top_bucket - y - (column.anchor - kRows / 2);
+        if (row < 0 || row >= kRows) continue;
+        if (const uint8_t level = column.levels[row]; level != 0) {
+          c.DrawBlock(static_cast<int>(x) * 2, y * 2, true, HeatColor(level));
+        }
+      }
+      // Mid price trace.
+      const int mid_y = static_cast<int>(top_bucket - column.anchor);
+      if (mid_y >= 0 && mid_y < rows) {
+        c.DrawBlock(static_cast<int>(x) * 2, mid_y * 2, true,
+                    ftxui::Color::White);
+      }
+    }
+
+    c.DrawText(0, 0, std::format("{:.2f}", top_bucket * tick_));
+    c.DrawText(0, std::max(0, (c.height() / 4 - 1) * 4),
+               std::format("{:.2f}  {} cols  {} KiB",
+                           (top_bucket - rows + 1) * tick_, history_.size(),
+                           history_.bytes() / 1024));
+    if (dropped_ != 0) {
+      c.DrawText(c.width() / 2, 0, std::format("{} cols dropped", dropped_),
+                 ftxui::Color::Yellow);
+    }
+  }
+
+  // Dark blue for thin levels through yellow for the heaviest ones.
+  static ftxui::Color HeatColor(const uint8_t level) {
+    const float t = static_cast<float>(level) / 255.0f;
+    return ftxui::Color::Interpolate(t, ftxui::Color::RGB(0, 0, 96),
+                                     ftxui::Color::RGB(255, 224, 0));
+  }
+
+  component::EventBus<HeatmapColumn> bus_;
+  publish_subject<component::RedrawSignal>& update_subject_;
+  component::CachedCanvas canvas_{[this](ftxui::Canvas& c) { Draw(c); }};
+  double tick_ = 0.0;  // written once, on the io thread, before any column
+  LiquidityHistory history_;
+  std::vector<HeatmapColumn> window_;
+  bool window_dirty_ = true;
+  uint64_t dropped_ = 0;  // columns lost to a full bus
+};
+
+ftxui::Component Heatmap(
+    const publish_subject<state::OrderBook>& order_book_input,
+    publish_subject<component::RedrawSignal>& output,
+    const size_t history_budget_bytes) {
+  return std::make_shared<LiquidityHeatmap>(order_book_input, output,
+                                            history_budget_bytes);
+}
+}  // namespace widget
@@ -19,14 +19,14 @@ class MarketTradesBody final
       : TableBody(trade_input, output) {}
 
   void ProcessEvent(const state::Trade& event) override {
-    std::lock_guard lock(mutex_);
-    events_.push_back(event);
+    AppendRow(event);
 
-    // Remove all events that are older than 1.5 minutes.
+    // Remove all events that are older than 1.5 minutes. Trades arrive in
+    // event time order, so the stale ones are always at the oldest end.
     constexpr auto duration =
         std::chrono::minutes(1) + std::chrono::seconds(30);
     const auto cutoff_ms = event.event_time - duration;
-    std::erase_if(events_, [cutoff_ms](const state::Trade& trade) {
+    EvictOldestWhile([cutoff_ms](const state::Trade& trade) {
       return trade.event_time < cutoff_ms;
     });
   }
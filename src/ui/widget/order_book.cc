@@ -1,6 +1,5 @@
 module;
-#include <mutex>
-#include <ranges>
+#include <deque>
 
 #include "ftxui/component/component.hpp"
 #include "rpp/subjects/publish_subject.hpp"
@@ -16,12 +15,32 @@ class OrderBookSideBody final
   OrderBookSideBody(
       const publish_subject<state::OrderBookSide>& order_book_input,
       publish_subject<component::RedrawSignal>& output)
-      : TableBody(order_book_input, output) {}
+      : TableBody(order_book_input, output, component::Delivery::kLatest) {}
 
+  // Merge the new side into the cached rows: both are sorted by price, so
+  // only levels whose quantity changed are formatted again.
   void ProcessEvent(const state::OrderBookSide& event) override {
-    std::lock_guard lock(mutex_);
-    events_.clear();
-    events_ = std::ranges::to<std::vector>(event | std::views::values);
+    std::deque<Row> next;
+    auto old = rows_.begin();
+    const auto drop_old = [this, &old] {
+      content_widths_.Remove(old->cells);
+      ++old;
+    };
+    for (const auto& [price, entry] : event) {
+      while (old != rows_.end() && old->state.price < price) drop_old();
+      if (old != rows_.end() && old->state.price == price) {
+        if (old->state.quantity == entry.quantity) {
+          next.push_back(std::move(*old));
+          ++old;
+          continue;
+        }
+        drop_old();
+      }
+      Row& row = next.emplace_back(MakeRow(entry));
+      content_widths_.Add(row.cells);
+    }
+    while (old != rows_.end()) drop_old();
+    rows_ = std::move(next);
   }
 
   RowType BuildRow(const state::OrderBookEntry& entry) const override {
@@ -44,31 +63,29 @@ class OrderBookMidPrice final : public ftxui::ComponentBase {
       : update_subject_{output} {
     order_book_input.get_observable().subscribe(
         [this](const state::OrderBook& ob) {
-          if (ob.bids.empty() && ob.asks.empty()) {
+          if (ob.bids.empty() || ob.asks.empty()) {
             return;  // TODO: handle case where there are no bids or asks.
           }
-          {
-            // For bids, the best (highest) price is at the end of the map.
-            const double best_bid = ob.bids.rbegin()->first;
-            // For asks, the best (lowest) price is at the beginning of the map.
-            const double best_ask = ob.asks.begin()->first;
-
-            std::lock_guard lock(mutex_);
-            prev_mid_price = mid_price_;
-            mid_price_ = (best_bid + best_ask) / 2.0;
-          }
-          update_subject_.get_observer().on_next(component::RedrawSignal{});
+          // For bids, the best (highest) price is at the end of the map.
+          const double best_bid = ob.bids.rbegin()->first;
+          // For asks, the best (lowest) price is at the beginning of the map.
+          const double best_ask = ob.asks.begin()->first;
+          quote_.mid = (best_bid + best_ask) / 2.0;
+          Publish();
         });
     quote_to_usdt_trades_input.get_observable().subscribe(
         [this](const state::Trade& trade) {
-          std::lock_guard lock(mutex_);
-          mark_price_ = trade.price * mid_price_;
-          update_subject_.get_observer().on_next(component::RedrawSignal{});
+          if (quote_.mid == 0.0) return;  // no book yet
+          quote_.mark = trade.price * quote_.mid;
+          Publish();
         });
   }
 
   ftxui::Element Render() override {
-    std::lock_guard lock(mutex_);
+    bus_.drain([this](const Quote& quote) {
+      mark_price_ = quote.mark;
+      UpdateMid(quote.mid);
+    });
 
     // Choose color and arrow direction based on price movement.
     constexpr std::array colors = {
@@ -95,6 +112,27 @@ class OrderBookMidPrice final : public ftxui::ComponentBase {
   }
 
  private:
+  // Prices computed on the io thread. Only the newest pair matters, so they
+  // reach Render through a snapshot bus like the book sides.
+  struct Quote {
+    double mid = 0.0;
+    double mark = 0.0;
+  };
+
+  // io thread.
+  void Publish() {
+    bus_.publish(quote_);
+    update_subject_.get_observer().on_next(
+        component::RedrawSignal{dirty_bit_});
+  }
+
+  // UI thread.
+  void UpdateMid(const double mid) {
+    if (mid == mid_price_) return;
+    prev_mid_price = mid_price_;
+    mid_price_ = mid;
+  }
+
   // Convert a floating-point number to a string and draw each character in
   // pixel-art style.
   static int DrawNumber(ftxui::Canvas& canvas, const float number,
@@ -128,8 +166,11 @@ class OrderBookMidPrice final : public ftxui::ComponentBase {
     }
   }
 
-  mutable std::mutex mutex_;
+  component::EventBus<Quote> bus_{component::Delivery::kLatest};
+  Quote quote_{};  // io thread only
   publish_subject<component::RedrawSignal>& update_subject_;
+  const component::DirtyMask dirty_bit_ = component::RegisterDirtyBit();
+  // UI thread only.
   double mark_price_ = 0.0;
   double mid_price_ = 0.0;
   double prev_mid_price = 0.0;
@@ -156,6 +197,11 @@ const std::unordered_map<char, std::array<std::string, 5>>
         {arrow_up, {" # ", "###", " # ", " # ", " # "}},
         {arrow_down, {" # ", " # ", " # ", "###", " # "}}};
 
+namespace {
+// Book levels visible on each side.
+constexpr int kLevelsPerSide = 10;
+}  // namespace
+
 // OrderBook function constructs the order book widget
 // with the following structure:
 //
@@ -173,7 +219,7 @@ ftxui::Component OrderBook(
   publish_subject<state::OrderBookSide> asks_subject;
   publish_subject<state::OrderBookSide> bids_subject;
   order_book_input.get_observable().subscribe(
-      [&asks_subject, &bids_subject](const state::OrderBook& ob) {
+      [asks_subject, bids_subject](const state::OrderBook& ob) {
         asks_subject.get_observer().on_next(ob.asks);
         bids_subject.get_observer().on_next(ob.bids);
       });
@@ -184,15 +230,24 @@ ftxui::Component OrderBook(
   auto bids = std::make_shared<OrderBookSideBody>(bids_subject, output);
   auto mid_price = std::make_shared<OrderBookMidPrice>(
       order_book_input, quote_to_usdt_trades_input, output);
+  // Each side only renders the levels in its viewport, whatever the depth.
+  // Asks are displayed highest first, so their view starts at the best ask.
+  auto asks_view = component::VirtualScroller(asks, kLevelsPerSide, true);
+  auto bids_view = component::VirtualScroller(bids, kLevelsPerSide);
+  const auto sides = ftxui::Container::Vertical({asks_view, bids_view});
 
   // Create the widget
-  return ftxui::Renderer([&header, &asks, &mid_price, &bids] {
+  return ftxui::Renderer(sides, [header, asks, asks_view, mid_price, bids,
+                                 bids_view] {
+    asks->Sync();
+    bids->Sync();
+    using ftxui::EQUAL, ftxui::HEIGHT;
     return ftxui::vbox({
         ftxui::text(L"Order Book"),
         header->Render(),
-        asks->Render(),
+        asks_view->Render() | ftxui::size(HEIGHT, EQUAL, kLevelsPerSide),
         mid_price->Render(),
-        bids->Render(),
+        bids_view->Render() | ftxui::size(HEIGHT, EQUAL, kLevelsPerSide),
     });
   });
 }
@@ -0,0 +1,79 @@
+module;
+#include <format>
+#include <string>
+#include <vector>
+
+#include "ftxui/component/component.hpp"
+#include "ftxui/dom/elements.hpp"
+#include "ftxui/dom/table.hpp"
+
+module ui.widget;
+
+import telemetry;
+
+namespace widget {
+namespace {
+std::string FormatDuration(const int64_t ns) {
+  if (ns < 1'000) return std::format("{}ns", ns);
+  if (ns < 1'000'000) return std::format("{:.1f}us", ns / 1e3);
+  if (ns < 1'000'000'000) return std::format("{:.1f}ms", ns / 1e6);
+  return std::format("{:.2f}s", ns / 1e9);
+}
+
+std::vector<std::string> Row(const std::string& name, const std::string& count,
+                             const int64_t p50, const int64_t p99,
+                             const int64_t max) {
+  return {name, count, FormatDuration(p50), FormatDuration(p99),
+          FormatDuration(max)};
+}
+}  // namespace
+
+// Snapshot of the metrics registry and of the tracer's data age per stage,
+// re-read on every frame.
+class StatsPanel final : public ftxui::ComponentBase {
+ public:
+  ftxui::Element Render() override {
+    using namespace ftxui;
+    std::vector<std::vector<std::string>> latency = {
+        {"data age", "count", "p50", "p99", "max"}};
+    const auto& tracer = telemetry::tracer();
+    for (size_t i = 0; i < telemetry::kStageNames.size(); ++i) {
+      const auto& histogram =
+          tracer.histogram(static_cast<telemetry::Stage>(i));
+      latency.push_back(Row(telemetry::kStageNames[i],
+                            std::to_string(histogram.count()),
+                            histogram.percentile(0.5),
+                            histogram.percentile(0.99), histogram.max()));
+    }
+
+    std::vector<std::vector<std::string>> values = {{"metric", "value"}};
+    std::vector<std::vector<std::string>> timings = {
+        {"timing", "count", "p50", "p99", "max"}};
+    for (const auto& sample : telemetry::metrics().snapshot()) {
+      const std::string name =
+          sample.labels.empty() ? sample.name
+                                : sample.name + "{" + sample.labels + "}";
+      if (sample.type == telemetry::MetricType::kHistogram) {
+        timings.push_back(Row(name, std::format("{:.0f}", sample.value),
+                              sample.p50, sample.p99, sample.max));
+      } else {
+        values.push_back({name, std::format("{:.0f}", sample.value)});
+      }
+    }
+
+    const auto table = [](std::vector<std::vector<std::string>> rows) {
+      Table t(std::move(rows));
+      t.SelectRow(0).Decorate(bold);
+      t.SelectColumns(1, -1).DecorateCells(align_right);
+      t.SelectAll().SeparatorVertical(EMPTY);
+      return t.Render();
+    };
+    return vbox({table(std::move(latency)), separatorEmpty(),
+                 table(std::move(timings)), separatorEmpty(),
+                 table(std::move(values))}) |
+           yframe;
+  }
+};
+
+ftxui::Component Stats() { return std::make_shared<StatsPanel>(); }
+}  // namespace widget
@@ -0,0 +1,170 @@
+module;
+#include <algorithm>
+#include <format>
+#include <vector>
+
+#include "ftxui/component/component.hpp"
+#include "ftxui/dom/table.hpp"
+#include "rpp/subjects/publish_subject.hpp"
+
+module ui.widget;
+
+import state;
+import ui.component;
+
+namespace widget {
+// Table body over all markets, sorted by 24h quote volume.
+//
+// Rows are indexed by the handler's dense symbol id. A batch only reformats
+// and re-sorts its own rows: they are taken out of the sort order, sorted
+// among themselves and merged back in, so unchanged rows are never
+// reformatted or compared against each other.
+class WatchlistBody final : public component::ITableBody {
+ public:
+  WatchlistBody(const publish_subject<state::TickerBatch>& ticker_input,
+                publish_subject<component::RedrawSignal>& output)
+      : bus_(component::Delivery::kQueued, 256), update_subject_(output) {
+    ticker_input.get_observable().subscribe(
+        [this](const state::TickerBatch& batch) {
+          bus_.publish(batch);
+          update_subject_.get_observer().on_next(
+              component::RedrawSignal{dirty_bit_});
+        });
+  }
+
+  void Sync() override {
+    bus_.drain([this](const state::TickerBatch& batch) { Apply(batch); });
+  }
+
+  [[nodiscard]] size_t RowCount() const override { return order_.size(); }
+
+  ftxui::Element RenderRows(const size_t first, const size_t count) override {
+    using namespace ftxui;
+    const size_t end = std::min(order_.size(), first + count);
+    if (first >= end) return emptyElement();
+
+    std::vector<std::vector<Element>> rows_elements;
+    rows_elements.reserve(end - first);
+    for (size_t display = first; display < end; ++display) {
+      const uint32_t id = order_[display];
+      const auto& cells = cells_[id];
+      const Color change_color =
+          close_[id] >= open_[id] ? Color::Green : Color::Red;
+      std::vector<Element> row;
+      row.reserve(cells.size());
+      for (size_t i = 0; i < cells.size(); ++i) {
+        const size_t width = i < col_widths_.size() ? col_widths_[i] : 10;
+        row.push_back(text(cells[i]) |
+                      size(WIDTH, EQUAL, static_cast<int>(width)) |
+                      color(i == 2 ? change_color : Color::White));
+      }
+      rows_elements.push_back(std::move(row));
+    }
+    Table body_table(std::move(rows_elements));
+    return body_table.Render() | bgcolor(Color::Black);
+  }
+
+  ftxui::Element Render() override {
+    Sync();
+    return RenderRows(0, order_.size());
+  }
+
+  [[nodiscard]] const std::vector<size_t>& getContentWidths() const override {
+    return content_widths_.Widths();
+  }
+
+  void setColumnWidths(const std::vector<size_t>& new_widths) override {
+    if (new_widths == col_widths_)
+      return;  // to avoid infinite cycle of redraws
+    col_widths_ = new_widths;
+    update_subject_.get_observer().on_next(component::RedrawSignal{dirty_bit_});
+  }
+
+  [[nodiscard]] component::BusStats getBusStats() const override {
+    return bus_.stats();
+  }
+
+ private:
+  void Apply(const state::TickerBatch& batch) {
+    changed_.clear();
+    for (const auto& row : batch.rows) {
+      if (row.id >= symbols_.size()) {
+        // New symbols are reported in id order.
+        symbols_.resize(row.id + 1);
+        close_.resize(row.id + 1);
+        open_.resize(row.id + 1);
+        quote_volume_.resize(row.id + 1);
+        cells_.resize(row.id + 1);
+        in_batch_.resize(row.id + 1, false);
+      }
+      // Every row names its symbol, so a row first seen in a batch after a
+      // dropped one still gets its name.
+      if (symbols_[row.id].empty()) symbols_[row.id] = row.symbol;
+      close_[row.id] = row.close;
+      open_[row.id] = row.open;
+      quote_volume_[row.id] = row.quote_volume;
+
+      if (!cells_[row.id].empty()) content_widths_.Remove(cells_[row.id]);
+      cells_[row.id] = BuildRow(row.id);
+      content_widths_.Add(cells_[row.id]);
+
+      if (!in_batch_[row.id]) {
+        in_batch_[row.id] = true;
+        changed_.push_back(row.id);
+      }
+    }
+
+    // Take the changed rows out, sort them and merge them back in.
+    std::erase_if(order_, [this](const uint32_t id) { return in_batch_[id]; });
+    const auto by_volume = [this](const uint32_t a, const uint32_t b) {
+      return quote_volume_[a] > quote_volume_[b];
+    };
+    std::ranges::sort(changed_, by_volume);
+    const auto middle = order_.insert(order_.end(), changed_.begin(),
+                                      changed_.end());
+    std::inplace_merge(order_.begin(), middle, order_.end(), by_volume);
+    for (const uint32_t id : changed_) in_batch_[id] = false;
+  }
+
+  [[nodiscard]] std::vector<std::string> BuildRow(const uint32_t id) const {
+    const double change =
+        open_[id] != 0.0 ? (close_[id] - open_[id]) / open_[id] * 100.0 : 0.0;
+    const double volume = quote_volume_[id];
+    return {
+        symbols_[id],
+        std::format("{:.8g}", close_[id]),
+        std::format("{:+.2f}%", change),
+        volume >= 1e6 ? std::format("{:.2f}M", volume / 1e6)
+                      : std::format("{:.2f}K", volume / 1e3),
+    };
+  }
+
+  component::EventBus<state::TickerBatch> bus_;
+  publish_subject<component::RedrawSignal>& update_subject_;
+  const component::DirtyMask dirty_bit_ = component::RegisterDirtyBit();
+
+  // Struct-of-arrays indexed by symbol id.
+  std::vector<std::string> symbols_;
+  std::vector<double> close_;
+  std::vector<double> open_;
+  std::vector<double> quote_volume_;
+  std::vector<std::vector<std::string>> cells_;
+  std::vector<bool> in_batch_;
+
+  std::vector<uint32_t> order_;    // ids, highest quote volume first
+  std::vector<uint32_t> changed_;  // ids of the batch being applied
+  component::ColumnWidthTracker content_widths_;
+  std::vector<size_t> col_widths_ = {10, 10, 10, 10};
+};
+
+ftxui::Component Watchlist(
+    const publish_subject<state::TickerBatch>& ticker_input,
+    const publish_subject<std::vector<std::string>>& header_input,
+    publish_subject<component::RedrawSignal>& output) {
+  auto header_component =
+      std::make_shared<component::TableHeader>(header_input, output);
+  auto body_component = std::make_shared<WatchlistBody>(ticker_input, output);
+  return std::make_shared<component::ScrollableTable>(header_component,
+                                                      body_component, output);
+}
+}  // namespace widget
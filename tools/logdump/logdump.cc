@@ -0,0 +1,119 @@
+// Renders a binary log written with `terminal --binary-log=<file>` as text,
+// one line per record in the order the writer thread drained them.
+//
+// Usage: logdump <file>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+import telemetry;
+
+namespace {
+constexpr std::string_view kMagic("BTBINLOG", 8);
+constexpr size_t kHeaderSize = 16;  // magic and version
+constexpr uint64_t kVersion = 1;
+constexpr std::array<std::string_view, 6> kLevelNames = {
+    "trace", "debug", "info", "warning", "error", "critical"};
+
+struct Site {
+  telemetry::LogLevel level;
+  std::string format;
+};
+
+// Sequential reader over the file contents.
+class Cursor {
+ public:
+  explicit Cursor(const std::string_view data) : data_(data) {}
+
+  [[nodiscard]] bool done() const { return offset_ >= data_.size(); }
+  [[nodiscard]] bool has(const size_t n) const {
+    return offset_ + n <= data_.size();
+  }
+
+  template <typename T>
+  T read() {
+    T value;
+    std::memcpy(&value, data_.data() + offset_, sizeof(value));
+    offset_ += sizeof(value);
+    return value;
+  }
+  std::string_view bytes(const size_t n) {
+    const auto out = data_.substr(offset_, n);
+    offset_ += n;
+    return out;
+  }
+  [[nodiscard]] size_t offset() const { return offset_; }
+
+ private:
+  std::string_view data_;
+  size_t offset_ = 0;
+};
+
+std::string FormatTime(const int64_t ns) {
+  using namespace std::chrono;
+  const sys_time<nanoseconds> time{nanoseconds{ns}};
+  return std::format("{:%F %T}", floor<microseconds>(time));
+}
+}  // namespace
+
+int main(const int argc, char* argv[]) {
+  if (argc != 2) {
+    std::cerr << "usage: logdump <file>\n";
+    return 1;
+  }
+  std::ifstream in(argv[1], std::ios::binary);
+  const std::string data(std::istreambuf_iterator<char>(in), {});
+  Cursor cursor(data);
+  if (!cursor.has(kHeaderSize) || cursor.bytes(kMagic.size()) != kMagic ||
+      cursor.read<uint64_t>() != kVersion) {
+    std::cerr << "not a binary log: " << argv[1] << '\n';
+    return 1;
+  }
+
+  std::unordered_map<uint32_t, Site> sites;
+  while (!cursor.done()) {
+    const auto kind = cursor.read<uint8_t>();
+    if (kind == 1 && cursor.has(9)) {  // site
+      const auto id = cursor.read<uint32_t>();
+      const auto level = cursor.read<telemetry::LogLevel>();
+      const auto size = cursor.read<uint32_t>();
+      if (!cursor.has(size)) break;
+      sites[id] = Site{level, std::string(cursor.bytes(size))};
+    } else if (kind == 2 && cursor.has(4 + 16)) {  // event
+      const auto thread = cursor.read<uint32_t>();
+      const auto size = cursor.read<uint32_t>();
+      const auto site_id = cursor.read<uint32_t>();
+      const auto time = cursor.read<int64_t>();
+      if (size < 16 || !cursor.has(size - 16)) break;
+      const std::string_view args = cursor.bytes(size - 16);
+      const auto site = sites.find(site_id);
+      if (site == sites.end()) {
+        std::cerr << "record for unknown site " << site_id << '\n';
+        continue;
+      }
+      std::cout << '[' << FormatTime(time) << "] ["
+                << kLevelNames.at(static_cast<size_t>(site->second.level))
+                << "] [thread " << thread << "] "
+                << telemetry::format_log(site->second.format, args) << '\n';
+    } else if (kind == 3 && cursor.has(12)) {  // drops
+      const auto thread = cursor.read<uint32_t>();
+      const auto dropped = cursor.read<uint64_t>();
+      std::cout << "[thread " << thread << "] " << dropped
+                << " records dropped so far (ring full)\n";
+    } else {
+      std::cerr << "truncated or corrupt record at offset "
+                << cursor.offset() - 1 << '\n';
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,736 @@
+// Local stand-in for the Binance WebSocket endpoints, for offline end-to-end
+// throughput, latency and resync testing.
+//
+// Serves both APIs on one TLS port with an in-memory self-signed certificate:
+//   wss://localhost:<port>/stream      combined streams: SUBSCRIBE,
+//                                      UNSUBSCRIBE, LIST_SUBSCRIPTIONS,
+//                                      <symbol>@aggTrade,
+//                                      <symbol>@depth[@100ms]
+//   wss://localhost:<port>/ws-api/v3   WS-API `depth`, `time`,
+//                                      `order.place` and `order.cancel`
+//                                      methods
+//   wss://localhost:<port>/sbe/stream  SBE binary frames (see module `sbe`):
+//                                      <symbol>@trade, <symbol>@depth
+//
+// Depth diffs carry consecutive U/u ranges, so a client that applies them on
+// top of a `depth` snapshot tracks the generated book exactly. Event times
+// ("E") are stamped when the message is queued for sending. Orders are
+// acknowledged and kept open until cancelled; they never fill.
+//
+// Usage: mock_server [--port=9443] [--trade-rate=1000] [--depth-interval=100]
+//                    [--levels-per-diff=20] [--depth=5000] [--gap-every=0]
+//                    [--disconnect-after=0] [--seed=42] [--stamp]
+//                    [--deflate] [--api-secret=<secret>]
+//   --trade-rate        aggTrade events per second per symbol
+//   --depth-interval    milliseconds between depth diffs
+//   --gap-every         drop every Nth depth diff (0: never)
+//   --disconnect-after  close a stream connection after N events (0: never)
+//   --stamp             add "sent_ns" (send time in ns) to each stream event,
+//                       for bench/transport/feed.cc
+//   --deflate           accept permessage-deflate offers (the client's
+//                       window bits and context takeover requests apply)
+//   --api-secret        verify order HMAC-SHA256 signatures with this secret
+//                       (unchecked by default, and always for Ed25519)
+//
+// Run the terminal against it with
+//   terminal --streams=wss://localhost:9443/stream \
+//            --api=wss://localhost:9443/ws-api/v3 --insecure
+// adding `--sbe=trade,depth --sbe-streams=wss://localhost:9443/sbe/stream`
+// to receive those streams as SBE. SBE events are transcoded from the same
+// generated JSON events; --stamp applies to JSON streams only. Order entry
+// (`--order-qty`, see src/main.cc) runs against the same --api endpoint;
+// start the server with the BINANCE_API_SECRET value as --api-secret to
+// have its signatures checked.
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <format>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "boost/asio.hpp"
+#include "boost/asio/ssl.hpp"
+#include "boost/beast/core/buffers_to_string.hpp"
+#include "boost/beast/core/flat_buffer.hpp"
+#include "boost/beast/http.hpp"
+#include "boost/beast/ssl.hpp"
+#include "boost/beast/websocket.hpp"
+#include "boost/beast/websocket/ssl.hpp"
+#include "nlohmann/json.hpp"
+#include "openssl/evp.h"
+#include "openssl/hmac.h"
+#include "openssl/x509.h"
+#include "spdlog/spdlog.h"
+
+import sbe;
+
+namespace asio = boost::asio;
+namespace beast = boost::beast;
+namespace websocket = beast::websocket;
+using asio::ip::tcp;
+
+namespace {
+struct Options {
+  unsigned short port = 9443;
+  int trade_rate = 1000;
+  int depth_interval_ms = 100;
+  int levels_per_diff = 20;
+  int depth = 5000;
+  int gap_every = 0;
+  int disconnect_after = 0;
+  uint64_t seed = 42;
+  bool stamp = false;
+  bool deflate = false;
+  std::string api_secret;
+};
+
+Options ParseOptions(const int argc, char* argv[]) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const auto value_of = [&arg](const std::string_view name, auto& out) {
+      if (!arg.starts_with(name) || arg.size() <= name.size() ||
+          arg[name.size()] != '=') {
+        return;
+      }
+      const auto value = arg.substr(name.size() + 1);
+      std::from_chars(value.data(), value.data() + value.size(), out);
+    };
+    value_of("--port", options.port);
+    value_of("--trade-rate", options.trade_rate);
+    value_of("--depth-interval", options.depth_interval_ms);
+    value_of("--levels-per-diff", options.levels_per_diff);
+    value_of("--depth", options.depth);
+    value_of("--gap-every", options.gap_every);
+    value_of("--disconnect-after", options.disconnect_after);
+    value_of("--seed", options.seed);
+    if (arg == "--stamp") options.stamp = true;
+    if (arg == "--deflate") options.deflate = true;
+    if (arg.starts_with("--api-secret=")) {
+      options.api_secret = arg.substr(std::string_view("--api-secret=").size());
+    }
+  }
+  return options;
+}
+
+int64_t NowNs() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(system_clock::now().time_since_epoch())
+      .count();
+}
+
+int64_t NowMs() {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string Decimal(const double value, const int precision) {
+  return std::format("{:.{}f}", value, precision);
+}
+
+nlohmann::json ApiError(const int code, const std::string& msg) {
+  return {{"status", 400}, {"error", {{"code", code}, {"msg", msg}}}};
+}
+
+// ---------------------------------------------------------------------------
+// SBE transcoding.
+// ---------------------------------------------------------------------------
+
+// Binance sends BTCUSDT prices and quantities with eight decimals.
+constexpr int8_t kSbeExponent = -8;
+
+int64_t Mantissa(const nlohmann::json& decimal) {
+  return sbe::mantissa(decimal.get_ref<const std::string&>(), kSbeExponent)
+      .value_or(0);
+}
+
+std::string TradeFrame(const std::string& data) {
+  const auto j = nlohmann::json::parse(data);
+  const sbe::TradeFields trade{.id = j.at("a").get<int64_t>(),
+                               .price = Mantissa(j.at("p")),
+                               .qty = Mantissa(j.at("q")),
+                               .is_buyer_maker = j.at("m").get<bool>()};
+  return sbe::encode_trades(j.at("E").get<int64_t>() * 1000,
+                            j.at("T").get<int64_t>() * 1000, kSbeExponent,
+                            kSbeExponent, {&trade, 1},
+                            j.at("s").get_ref<const std::string&>());
+}
+
+std::string DepthFrame(const std::string& data) {
+  const auto j = nlohmann::json::parse(data);
+  const auto levels = [](const nlohmann::json& side) {
+    std::vector<sbe::LevelFields> out;
+    for (const auto& level : side) {
+      out.push_back({Mantissa(level.at(0)), Mantissa(level.at(1))});
+    }
+    return out;
+  };
+  return sbe::encode_depth_diff(
+      j.at("E").get<int64_t>() * 1000, j.at("U").get<int64_t>(),
+      j.at("u").get<int64_t>(), kSbeExponent, kSbeExponent,
+      levels(j.at("b")), levels(j.at("a")),
+      j.at("s").get_ref<const std::string&>());
+}
+
+// ---------------------------------------------------------------------------
+// TLS.
+// ---------------------------------------------------------------------------
+
+// Self-signed P-256 certificate for CN=localhost, generated at startup so the
+// tool needs no files. The terminal's client does not pin certificates.
+void UseSelfSignedCertificate(asio::ssl::context& ctx) {
+  EVP_PKEY* key = EVP_EC_gen("prime256v1");
+  X509* cert = X509_new();
+  X509_set_version(cert, 2);
+  ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+  X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+  X509_gmtime_adj(X509_getm_notAfter(cert), 365L * 24 * 3600);
+  X509_set_pubkey(cert, key);
+  X509_NAME* name = X509_get_subject_name(cert);
+  X509_NAME_add_entry_by_txt(
+      name, "CN", MBSTRING_ASC,
+      reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+  X509_set_issuer_name(cert, name);
+  X509_sign(cert, key, EVP_sha256());
+
+  SSL_CTX_use_certificate(ctx.native_handle(), cert);
+  SSL_CTX_use_PrivateKey(ctx.native_handle(), key);
+  X509_free(cert);
+  EVP_PKEY_free(key);
+}
+
+// ---------------------------------------------------------------------------
+// Connections.
+// ---------------------------------------------------------------------------
+using Stream = websocket::stream<beast::ssl_stream<tcp::socket>>;
+
+// One client connection. Writes go through a queue drained by a single
+// writer, since a websocket stream allows only one outstanding write.
+class Connection : public std::enable_shared_from_this<Connection> {
+ public:
+  Connection(Stream stream, const bool sbe_frames)
+      : sbe_frames(sbe_frames),
+        stream_(std::move(stream)),
+        wakeup_(stream_.get_executor(),
+                asio::steady_timer::time_point::max()) {}
+
+  void Send(std::string message, const bool binary = false) {
+    if (closed_) return;
+    outbox_.push_back({std::move(message), binary});
+    wakeup_.cancel();
+  }
+
+  void Close() {
+    closed_ = true;
+    wakeup_.cancel();
+  }
+
+  [[nodiscard]] bool closed() const { return closed_; }
+
+  asio::awaitable<void> WriteLoop() {
+    const auto self = shared_from_this();
+    try {
+      while (!closed_) {
+        while (!outbox_.empty() && !closed_) {
+          const Message message = std::move(outbox_.front());
+          outbox_.pop_front();
+          stream_.binary(message.binary);
+          co_await stream_.async_write(asio::buffer(message.data),
+                                       asio::use_awaitable);
+        }
+        if (closed_) break;
+        boost::system::error_code ec;
+        co_await wakeup_.async_wait(
+            asio::redirect_error(asio::use_awaitable, ec));
+      }
+      co_await stream_.async_close(websocket::close_code::going_away,
+                                   asio::use_awaitable);
+    } catch (const std::exception& e) {
+      spdlog::debug("write loop ended: {}", e.what());
+    }
+    closed_ = true;
+  }
+
+  Stream& stream() { return stream_; }
+
+  // Stream events go out as SBE binary frames instead of JSON.
+  const bool sbe_frames;
+  // Streams this connection is subscribed to.
+  std::set<std::string> subscriptions;
+  // Stream events sent, for --disconnect-after.
+  int events_sent = 0;
+
+ private:
+  struct Message {
+    std::string data;
+    bool binary;
+  };
+
+  Stream stream_;
+  asio::steady_timer wakeup_;
+  std::deque<Message> outbox_;
+  bool closed_ = false;
+};
+
+// ---------------------------------------------------------------------------
+// Market simulation.
+// ---------------------------------------------------------------------------
+
+// Random-walk order book and trade tape for one symbol.
+class Market {
+ public:
+  Market(std::string symbol, const Options& options, const uint64_t seed)
+      : symbol_(std::move(symbol)), options_(options), rng_(seed) {
+    for (int i = 1; i <= options_.depth; ++i) {
+      bids_[Level(-i)] = Quantity();
+      asks_[Level(i)] = Quantity();
+    }
+  }
+
+  [[nodiscard]] const std::string& symbol() const { return symbol_; }
+
+  std::string NextTrade() {
+    const double price =
+        (mid_ + std::normal_distribution<double>(0.0, 2.0)(rng_)) * kTick;
+    ++trade_id_;
+    const int64_t now = NowMs();
+    return std::format(
+        R"({{"e":"aggTrade","E":{},"s":"{}","a":{},"p":"{}","q":"{}",)"
+        R"("f":{},"l":{},"T":{},"m":{},"M":true}})",
+        now, Upper(), trade_id_, Decimal(price, 2), Decimal(Quantity(), 5),
+        trade_id_, trade_id_, now, rng_() % 2 == 0 ? "true" : "false");
+  }
+
+  // Mutate the book and describe the change as one depth diff. Every changed
+  // level consumes one update id, as on the exchange.
+  std::string NextDepth() {
+    mid_ += std::uniform_int_distribution<int64_t>(-2, 2)(rng_);
+    const int64_t first = update_id_ + 1;
+    nlohmann::json bids = nlohmann::json::array();
+    nlohmann::json asks = nlohmann::json::array();
+    std::uniform_int_distribution<int> offset(1, 50);
+    for (int i = 0; i < options_.levels_per_diff; ++i) {
+      const bool bid = i % 2 == 0;
+      auto& side = bid ? bids_ : asks_;
+      const int64_t level = Level(bid ? -offset(rng_) : offset(rng_));
+      // One in four changes removes the level.
+      const double qty = rng_() % 4 == 0 ? 0.0 : Quantity();
+      if (qty == 0.0) {
+        side.erase(level);
+      } else {
+        side[level] = qty;
+      }
+      (bid ? bids : asks)
+          .push_back({Decimal(level * kTick, 2), Decimal(qty, 5)});
+      ++update_id_;
+    }
+    TrimCrossed(bids, asks);
+    return nlohmann::json{{"e", "depthUpdate"},
+                          {"E", NowMs()},
+                          {"s", Upper()},
+                          {"U", first},
+                          {"u", update_id_},
+                          {"b", bids},
+                          {"a", asks}}
+        .dump();
+  }
+
+  // `depth` WS-API result at the current update id.
+  nlohmann::json Snapshot(const int limit) const {
+    nlohmann::json bids = nlohmann::json::array();
+    nlohmann::json asks = nlohmann::json::array();
+    for (const auto& [level, qty] : bids_ | std::views::reverse) {
+      if (std::ssize(bids) >= limit) break;
+      bids.push_back({Decimal(level * kTick, 2), Decimal(qty, 5)});
+    }
+    for (const auto& [level, qty] : asks_) {
+      if (std::ssize(asks) >= limit) break;
+      asks.push_back({Decimal(level * kTick, 2), Decimal(qty, 5)});
+    }
+    return {{"lastUpdateId", update_id_}, {"bids", bids}, {"asks", asks}};
+  }
+
+ private:
+  static constexpr double kTick = 0.01;
+
+  [[nodiscard]] int64_t Level(const int offset) const { return mid_ + offset; }
+
+  // Positive, with at most five decimals.
+  double Quantity() {
+    const double raw = std::exponential_distribution<double>(2.0)(rng_);
+    return (std::round(raw * 1e5) + 1) / 1e5;
+  }
+
+  // Keep the book uncrossed after the mid moved, reporting the removed levels
+  // in the same diff.
+  void TrimCrossed(nlohmann::json& bids, nlohmann::json& asks) {
+    while (!bids_.empty() && bids_.rbegin()->first >= mid_) {
+      bids.push_back({Decimal(bids_.rbegin()->first * kTick, 2), "0.00000"});
+      bids_.erase(std::prev(bids_.end()));
+      ++update_id_;
+    }
+    while (!asks_.empty() && asks_.begin()->first <= mid_) {
+      asks.push_back({Decimal(asks_.begin()->first * kTick, 2), "0.00000"});
+      asks_.erase(asks_.begin());
+      ++update_id_;
+    }
+  }
+
+  [[nodiscard]] std::string Upper() const {
+    std::string upper = symbol_;
+    for (char& c : upper) c = static_cast<char>(std::toupper(c));
+    return upper;
+  }
+
+  const std::string symbol_;
+  const Options& options_;
+  std::mt19937_64 rng_;
+  int64_t mid_ = 10'000'000;  // in ticks
+  int64_t update_id_ = 1'000'000;
+  uint64_t trade_id_ = 0;
+  std::map<int64_t, double> bids_;  // level (ticks) -> quantity
+  std::map<int64_t, double> asks_;
+};
+
+// ---------------------------------------------------------------------------
+// Server.
+// ---------------------------------------------------------------------------
+class Server {
+ public:
+  Server(asio::io_context& ioc, const Options& options)
+      : ioc_(ioc), options_(options), ssl_ctx_(asio::ssl::context::tls_server) {
+    UseSelfSignedCertificate(ssl_ctx_);
+  }
+
+  asio::awaitable<void> Listen() {
+    tcp::acceptor acceptor(ioc_, {tcp::v4(), options_.port});
+    spdlog::info("listening on wss://localhost:{}", options_.port);
+    while (true) {
+      tcp::socket socket = co_await acceptor.async_accept(asio::use_awaitable);
+      socket.set_option(tcp::no_delay(true));
+      asio::co_spawn(ioc_, Accept(std::move(socket)), asio::detached);
+    }
+  }
+
+ private:
+  asio::awaitable<void> Accept(tcp::socket socket) {
+    try {
+      Stream stream(std::move(socket), ssl_ctx_);
+      co_await stream.next_layer().async_handshake(
+          asio::ssl::stream_base::server, asio::use_awaitable);
+
+      // Read the upgrade request ourselves to route on its target.
+      beast::flat_buffer buffer;
+      beast::http::request<beast::http::string_body> request;
+      co_await beast::http::async_read(stream.next_layer(), buffer, request,
+                                       asio::use_awaitable);
+      if (options_.deflate) {
+        websocket::permessage_deflate pmd;
+        pmd.server_enable = true;
+        stream.set_option(pmd);
+      }
+      co_await stream.async_accept(request, asio::use_awaitable);
+
+      const std::string target(request.target());
+      const auto connection = std::make_shared<Connection>(
+          std::move(stream), target.starts_with("/sbe/"));
+      asio::co_spawn(ioc_, connection->WriteLoop(), asio::detached);
+      if (target.starts_with("/stream") || target.starts_with("/sbe/stream")) {
+        co_await ServeStreams(connection);
+      } else if (target.starts_with("/ws-api")) {
+        co_await ServeApi(connection);
+      } else {
+        spdlog::warn("unknown target {}", target);
+      }
+      connection->Close();
+    } catch (const std::exception& e) {
+      spdlog::debug("connection ended: {}", e.what());
+    }
+  }
+
+  asio::awaitable<void> ServeStreams(std::shared_ptr<Connection> connection) {
+    connections_.insert(connection);
+    try {
+      while (!connection->closed()) {
+        const auto request = nlohmann::json::parse(co_await Read(*connection));
+        const auto id = request.value("id", nlohmann::json());
+        const auto method = request.value("method", std::string());
+        nlohmann::json response = {{"result", nullptr}, {"id", id}};
+        if (method == "SUBSCRIBE") {
+          for (const auto& stream : request.at("params")) {
+            Subscribe(*connection, stream.get<std::string>());
+          }
+        } else if (method == "UNSUBSCRIBE") {
+          for (const auto& stream : request.at("params")) {
+            connection->subscriptions.erase(stream.get<std::string>());
+          }
+        } else if (method == "LIST_SUBSCRIPTIONS") {
+          response["result"] = connection->subscriptions;
+        } else {
+          response = {{"error", {{"code", 2}, {"msg", "Invalid request"}}},
+                      {"id", id}};
+        }
+        connection->Send(response.dump());
+      }
+    } catch (const std::exception& e) {
+      spdlog::debug("stream connection ended: {}", e.what());
+    }
+    connections_.erase(connection);
+  }
+
+  asio::awaitable<void> ServeApi(std::shared_ptr<Connection> connection) {
+    try {
+      while (!connection->closed()) {
+        const auto request = nlohmann::json::parse(co_await Read(*connection));
+        const auto method = request.value("method", std::string());
+        const auto params =
+            request.value("params", nlohmann::json::object());
+        nlohmann::json response;
+        if (method == "depth") {
+          response = Depth(params);
+        } else if (method == "time") {
+          response = {{"status", 200}, {"result", {{"serverTime", NowMs()}}}};
+        } else if (method == "order.place") {
+          response = PlaceOrder(params);
+        } else if (method == "order.cancel") {
+          response = CancelOrder(params);
+        } else {
+          response = ApiError(-1100, "Unknown");
+        }
+        response["id"] = request.value("id", nlohmann::json());
+        connection->Send(response.dump());
+      }
+    } catch (const std::exception& e) {
+      spdlog::debug("api connection ended: {}", e.what());
+    }
+  }
+
+  nlohmann::json Depth(const nlohmann::json& params) {
+    std::string symbol = params.at("symbol").get<std::string>();
+    for (char& c : symbol) c = static_cast<char>(std::tolower(c));
+    const int limit = std::min(params.value("limit", 100), 5000);
+    return {{"status", 200}, {"result", GetMarket(symbol).Snapshot(limit)}};
+  }
+
+  nlohmann::json PlaceOrder(const nlohmann::json& params) {
+    if (auto error = CheckSigned(params, {"price", "quantity", "side"})) {
+      return *std::move(error);
+    }
+    const int64_t order_id = next_order_id_++;
+    const auto client_order_id = params.value(
+        "newClientOrderId", std::format("mock{}", order_id));
+    if (!orders_.emplace(client_order_id, order_id).second) {
+      return ApiError(-2010, "Duplicate order sent.");
+    }
+    return {{"status", 200},
+            {"result",
+             {{"symbol", params.at("symbol")},
+              {"orderId", order_id},
+              {"orderListId", -1},
+              {"clientOrderId", client_order_id},
+              {"transactTime", NowMs()}}}};
+  }
+
+  nlohmann::json CancelOrder(const nlohmann::json& params) {
+    if (auto error = CheckSigned(params, {"origClientOrderId"})) {
+      return *std::move(error);
+    }
+    const auto client_order_id =
+        params.at("origClientOrderId").get<std::string>();
+    const auto it = orders_.find(client_order_id);
+    if (it == orders_.end()) return ApiError(-2011, "Unknown order sent.");
+    const int64_t order_id = it->second;
+    orders_.erase(it);
+    return {{"status", 200},
+            {"result",
+             {{"symbol", params.at("symbol")},
+              {"origClientOrderId", client_order_id},
+              {"orderId", order_id},
+              {"orderListId", -1},
+              {"status", "CANCELED"},
+              {"transactTime", NowMs()}}}};
+  }
+
+  // An error response if a signed request lacks a parameter or, with
+  // --api-secret, its signature does not match.
+  std::optional<nlohmann::json> CheckSigned(
+      const nlohmann::json& params,
+      const std::initializer_list<const char*> required) const {
+    std::vector<const char*> names = {"apiKey", "signature", "symbol",
+                                      "timestamp"};
+    names.insert(names.end(), required);
+    for (const char* name : names) {
+      if (!params.contains(name)) {
+        return ApiError(
+            -1102, std::format("Mandatory parameter '{}' was not sent.", name));
+      }
+    }
+    if (!options_.api_secret.empty() &&
+        params.at("signature") != Signature(params)) {
+      return ApiError(-1022, "Signature for this request is not valid.");
+    }
+    return std::nullopt;
+  }
+
+  // HMAC-SHA256 of the other parameters, sorted by name and joined as a
+  // query string.
+  std::string Signature(const nlohmann::json& params) const {
+    std::string payload;
+    for (const auto& [name, value] : params.items()) {
+      if (name == "signature") continue;
+      if (!payload.empty()) payload += '&';
+      payload += name;
+      payload += '=';
+      payload += value.is_string() ? value.get<std::string>() : value.dump();
+    }
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int size = 0;
+    HMAC(EVP_sha256(), options_.api_secret.data(),
+         static_cast<int>(options_.api_secret.size()),
+         reinterpret_cast<const unsigned char*>(payload.data()),
+         payload.size(), digest, &size);
+    std::string hex;
+    for (unsigned int i = 0; i < size; ++i) {
+      hex += std::format("{:02x}", digest[i]);
+    }
+    return hex;
+  }
+
+  static asio::awaitable<std::string> Read(Connection& connection) {
+    beast::flat_buffer buffer;
+    co_await connection.stream().async_read(buffer, asio::use_awaitable);
+    co_return beast::buffers_to_string(buffer.data());
+  }
+
+  void Subscribe(Connection& connection, const std::string& stream) {
+    const auto at = stream.find('@');
+    if (at == std::string::npos) return;
+    GetMarket(stream.substr(0, at));
+    connection.subscriptions.insert(stream);
+  }
+
+  // Markets start generating on first use, from either API.
+  Market& GetMarket(const std::string& symbol) {
+    if (const auto it = markets_.find(symbol); it != markets_.end()) {
+      return *it->second;
+    }
+    auto& market = *markets_
+                        .emplace(symbol, std::make_unique<Market>(
+                                             symbol, options_,
+                                             options_.seed + markets_.size()))
+                        .first->second;
+    asio::co_spawn(ioc_, TradeLoop(market), asio::detached);
+    asio::co_spawn(ioc_, DepthLoop(market), asio::detached);
+    return market;
+  }
+
+  asio::awaitable<void> TradeLoop(Market& market) {
+    if (options_.trade_rate <= 0) co_return;
+    const auto interval = std::chrono::nanoseconds(1'000'000'000) /
+                          options_.trade_rate;
+    const std::string stream = market.symbol() + "@aggTrade";
+    const std::string sbe_stream = market.symbol() + "@trade";
+    asio::steady_timer timer(ioc_, std::chrono::steady_clock::now());
+    while (true) {
+      timer.expires_at(timer.expiry() + interval);
+      co_await timer.async_wait(asio::use_awaitable);
+      const std::string data = market.NextTrade();
+      Broadcast({stream}, data);
+      BroadcastSbe(sbe_stream, [&data] { return TradeFrame(data); });
+    }
+  }
+
+  asio::awaitable<void> DepthLoop(Market& market) {
+    const auto interval = std::chrono::milliseconds(options_.depth_interval_ms);
+    const std::vector streams = {market.symbol() + "@depth",
+                                 market.symbol() + "@depth@100ms"};
+    const std::string sbe_stream = market.symbol() + "@depth";
+    asio::steady_timer timer(ioc_, std::chrono::steady_clock::now());
+    for (int64_t event = 1;; ++event) {
+      timer.expires_at(timer.expiry() + interval);
+      co_await timer.async_wait(asio::use_awaitable);
+      std::string data = market.NextDepth();
+      if (options_.gap_every > 0 && event % options_.gap_every == 0) {
+        spdlog::info("dropping depth diff {} of {}", event, market.symbol());
+        continue;
+      }
+      Broadcast(streams, data);
+      BroadcastSbe(sbe_stream, [&data] { return DepthFrame(data); });
+    }
+  }
+
+  void Broadcast(const std::vector<std::string>& streams,
+                 const std::string& data) {
+    for (const auto& connection : connections_) {
+      if (connection->sbe_frames) continue;
+      for (const auto& stream : streams) {
+        if (!connection->subscriptions.contains(stream)) continue;
+        if (options_.stamp) {
+          // Extend the event object: `{...}` -> `{...,"sent_ns":N}`.
+          connection->Send(std::format(
+              R"({{"stream":"{}","data":{},"sent_ns":{}}}}})", stream,
+              std::string_view(data).substr(0, data.size() - 1), NowNs()));
+        } else {
+          connection->Send(
+              std::format(R"({{"stream":"{}","data":{}}})", stream, data));
+        }
+        CountEvent(*connection);
+      }
+    }
+  }
+
+  // Send one event to the SBE connections subscribed to `stream`, encoding
+  // it only if there are any.
+  template <typename Encode>
+  void BroadcastSbe(const std::string& stream, const Encode& encode) {
+    std::string frame;
+    for (const auto& connection : connections_) {
+      if (!connection->sbe_frames ||
+          !connection->subscriptions.contains(stream)) {
+        continue;
+      }
+      if (frame.empty()) frame = encode();
+      connection->Send(frame, /*binary=*/true);
+      CountEvent(*connection);
+    }
+  }
+
+  void CountEvent(Connection& connection) const {
+    if (options_.disconnect_after > 0 &&
+        ++connection.events_sent >= options_.disconnect_after) {
+      spdlog::info("disconnecting after {} events", connection.events_sent);
+      connection.Close();
+    }
+  }
+
+  asio::io_context& ioc_;
+  const Options& options_;
+  asio::ssl::context ssl_ctx_;
+  std::unordered_map<std::string, std::unique_ptr<Market>> markets_;
+  std::unordered_set<std::shared_ptr<Connection>> connections_;
+  // Open orders by client order id.
+  std::unordered_map<std::string, int64_t> orders_;
+  int64_t next_order_id_ = 1;
+};
+}  // namespace
+
+int main(const int argc, char* argv[]) {
+  const Options options = ParseOptions(argc, argv);
+  asio::io_context io_context;
+  Server server(io_context, options);
+  asio::co_spawn(io_context, server.Listen(), asio::detached);
+  io_context.run();
+  return 0;
+}
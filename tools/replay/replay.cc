@@ -0,0 +1,213 @@
+// Replays a feed journal recorded with `terminal --journal=<file>` through
+// WebSocketStreams::process_message (process_binary for SBE frames) and the
+// state handlers.
+//
+// Stream frames are dispatched in recorded order. Order book snapshots are
+// served from the WS-API responses captured in the same journal, so depth
+// synchronization works offline and gives the same result on every run.
+//
+// Usage: replay <journal> [--pace=max|recorded] [--loops=N]
+#include <charconv>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "boost/asio/awaitable.hpp"
+#include "boost/asio/co_spawn.hpp"
+#include "boost/asio/detached.hpp"
+#include "boost/asio/io_context.hpp"
+#include "boost/asio/steady_timer.hpp"
+#include "boost/asio/use_awaitable.hpp"
+#include "nlohmann/json.hpp"
+#include "spdlog/spdlog.h"
+
+import exchange;
+import sbe;
+import state;
+
+namespace asio = boost::asio;
+
+namespace {
+struct Options {
+  std::string path;
+  bool recorded_pace = false;
+  int loops = 1;
+};
+
+// Snapshots in the order the recorded session received them.
+class JournalSnapshots final : public exchange::SnapshotSource {
+ public:
+  explicit JournalSnapshots(std::deque<std::string_view> responses)
+      : responses_(std::move(responses)) {}
+
+  asio::awaitable<exchange::OrderBookSnapshot> get_orderbook_snapshot(
+      const std::string& market) override {
+    if (responses_.empty()) {
+      throw std::runtime_error("no recorded snapshot left for " + market);
+    }
+    const auto response = nlohmann::json::parse(responses_.front());
+    responses_.pop_front();
+    co_return response.at("result").get<exchange::OrderBookSnapshot>();
+  }
+
+ private:
+  std::deque<std::string_view> responses_;
+};
+
+// What one pass over the journal needs to know up front.
+struct Index {
+  std::set<uint32_t> stream_connections;
+  std::set<std::string> streams;
+  std::deque<std::string_view> snapshots;
+  size_t frames = 0;
+};
+
+Index BuildIndex(exchange::JournalReader& reader) {
+  Index index;
+  std::set<uint32_t> api_connections;
+  reader.rewind();
+  while (const auto entry = reader.next()) {
+    const auto& record = entry->record;
+    if (record.kind == exchange::JournalKind::kConnection) {
+      if (entry->payload.contains("/stream")) {
+        index.stream_connections.insert(record.connection_id);
+      } else if (entry->payload.contains("/ws-api")) {
+        api_connections.insert(record.connection_id);
+      }
+      continue;
+    }
+    if (index.stream_connections.contains(record.connection_id)) {
+      ++index.frames;
+      if (record.kind == exchange::JournalKind::kBinaryFrame) {
+        if (std::string stream; sbe::stream_name(entry->payload, stream)) {
+          index.streams.insert(std::move(stream));
+        }
+        continue;
+      }
+      const auto frame = nlohmann::json::parse(entry->payload, nullptr, false);
+      if (!frame.is_discarded() && frame.contains("stream")) {
+        index.streams.insert(frame["stream"].get<std::string>());
+      }
+    } else if (api_connections.contains(record.connection_id) &&
+               entry->payload.contains("\"lastUpdateId\"")) {
+      index.snapshots.push_back(entry->payload);
+    }
+  }
+  return index;
+}
+
+struct Counts {
+  size_t frames = 0;
+  size_t bytes = 0;
+  size_t trades = 0;
+  size_t books = 0;
+  size_t quotes = 0;
+};
+
+asio::awaitable<void> Replay(exchange::JournalReader& reader,
+                             exchange::WebSocketStreams& ws,
+                             const Index& index, const bool recorded_pace,
+                             Counts& counts) {
+  const auto executor = co_await asio::this_coro::executor;
+  asio::steady_timer timer(executor);
+  const auto start = std::chrono::steady_clock::now();
+  int64_t first_ns = -1;
+
+  reader.rewind();
+  while (const auto entry = reader.next()) {
+    const auto& record = entry->record;
+    if (record.kind == exchange::JournalKind::kConnection ||
+        !index.stream_connections.contains(record.connection_id)) {
+      continue;
+    }
+    if (recorded_pace) {
+      if (first_ns < 0) first_ns = record.receive_ns;
+      timer.expires_at(start +
+                       std::chrono::nanoseconds(record.receive_ns - first_ns));
+      co_await timer.async_wait(asio::use_awaitable);
+    }
+    if (record.kind == exchange::JournalKind::kBinaryFrame) {
+      co_await ws.process_binary(entry->payload);
+    } else {
+      co_await ws.process_message(entry->payload);
+    }
+    ++counts.frames;
+    counts.bytes += entry->payload.size();
+  }
+}
+}  // namespace
+
+int main(const int argc, char* argv[]) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--pace=recorded") {
+      options.recorded_pace = true;
+    } else if (arg == "--pace=max") {
+      options.recorded_pace = false;
+    } else if (arg.starts_with("--loops=")) {
+      const auto value = arg.substr(std::string_view("--loops=").size());
+      std::from_chars(value.data(), value.data() + value.size(), options.loops);
+    } else {
+      options.path = arg;
+    }
+  }
+  if (options.path.empty()) {
+    std::cerr << "usage: replay <journal> [--pace=max|recorded] [--loops=N]\n";
+    return 1;
+  }
+  spdlog::set_level(spdlog::level::warn);
+
+  exchange::JournalReader reader(options.path);
+  const Index index = BuildIndex(reader);
+  std::cout << "journal: " << reader.size() << " bytes, " << index.frames
+            << " stream frames, " << index.streams.size() << " streams, "
+            << index.snapshots.size() << " snapshots\n";
+
+  Counts counts;
+  const auto start = std::chrono::steady_clock::now();
+  for (int loop = 0; loop < options.loops; ++loop) {
+    // Fresh handlers per pass: update ids restart from the beginning.
+    asio::io_context io_context;
+    JournalSnapshots snapshots(index.snapshots);
+    exchange::WebSocketStreams ws(io_context);
+    for (const auto& stream : index.streams) {
+      if (stream.ends_with("@aggTrade") || stream.ends_with("@trade")) {
+        auto handler = std::make_unique<state::TradeHandler>();
+        handler->get_subject().get_observable().subscribe(
+            [&counts](const state::Trade&) { ++counts.trades; });
+        ws.register_handler(stream, std::move(handler));
+      } else if (stream.contains("@depth")) {
+        auto handler = std::make_unique<state::OrderBookHandler>(snapshots);
+        handler->get_subject().get_observable().subscribe(
+            [&counts](const state::OrderBook&) { ++counts.books; });
+        ws.register_handler(stream, std::move(handler));
+      } else if (stream.ends_with("@bookTicker") ||
+                 stream.ends_with("@bestBidAsk")) {
+        auto handler = std::make_unique<state::BookTickerHandler>();
+        handler->get_subject().get_observable().subscribe(
+            [&counts](const state::BookTicker&) { ++counts.quotes; });
+        ws.register_handler(stream, std::move(handler));
+      }
+    }
+    asio::co_spawn(io_context,
+                   Replay(reader, ws, index, options.recorded_pace, counts),
+                   asio::detached);
+    io_context.run();
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::cout << "replayed " << counts.frames << " frames ("
+            << counts.bytes / 1e6 << " MB) in " << elapsed.count() << " s: "
+            << counts.frames / elapsed.count() << " msg/s, "
+            << counts.bytes / 1e6 / elapsed.count() << " MB/s\n"
+            << "published " << counts.trades << " trades, " << counts.books
+            << " books, " << counts.quotes << " quotes\n";
+  return 0;
+}
@@ -0,0 +1,52 @@
+// Follows the market data a terminal publishes with `--shm=<name>`: prints
+// each trade as it arrives and the best bid/offer of every book once a
+// second, and warns when the terminal stopped publishing. Shows how another
+// process uses shm::Reader.
+//
+// Usage: shm_reader <name>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+import shm;
+
+int main(const int argc, char* argv[]) {
+  if (argc != 2) {
+    std::cerr << "usage: shm_reader <name>\n";
+    return 1;
+  }
+  try {
+    shm::Reader reader(argv[1]);
+    auto next_report = std::chrono::steady_clock::now();
+    while (true) {
+      while (const auto trade = reader.next_trade()) {
+        std::cout << "trade " << shm::symbol_view(trade->symbol) << ' '
+                  << trade->trade_id << ' ' << trade->quantity << " @ "
+                  << trade->price << '\n';
+      }
+      if (std::chrono::steady_clock::now() >= next_report) {
+        next_report += std::chrono::seconds(1);
+        for (const auto& symbol : reader.symbols()) {
+          shm::Bbo bbo{};
+          if (!reader.read_bbo(symbol, bbo)) continue;
+          std::cout << "bbo " << symbol << ' ' << bbo.bid.quantity << " @ "
+                    << bbo.bid.price << " / " << bbo.ask.quantity << " @ "
+                    << bbo.ask.price << " (update " << bbo.update_id << ")\n";
+        }
+        if (reader.trades_lost() != 0) {
+          std::cout << "trades lost: " << reader.trades_lost() << '\n';
+        }
+        const auto age = std::chrono::system_clock::now().time_since_epoch() -
+                         std::chrono::nanoseconds(reader.heartbeat_ns());
+        if (age > 10 * shm::Publisher::kHeartbeatInterval) {
+          std::cout << "publisher stopped\n";
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+}